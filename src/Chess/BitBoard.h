@@ -21,6 +21,19 @@ inline Square GetSquare(BitBoard board) {
 inline uint64_t SquareCount(BitBoard board) {
     return __popcnt64(board);
 }
+#elif defined(__GNUC__) || defined(__clang__)
+// Returns least significant bit on bitboard
+// Returns 0 if board is 0
+inline Square GetSquare(BitBoard board) {
+    // __builtin_ctzll() is undefined for 0 (this compiles to a conditional move, not a branch)
+    return board != 0 ? static_cast<Square>(__builtin_ctzll(board)) : 0;
+}
+
+// Gets the number of bits set
+// (a single POPCNT instruction on x86-64-v2 and later, see CHESS_MULTIVERSION below)
+inline uint64_t SquareCount(BitBoard board) {
+    return __builtin_popcountll(board);
+}
 #else
 // Returns least significant bit on bitboard
 // Returns 0 if board is 0
@@ -37,14 +50,6 @@ inline Square GetSquare(BitBoard board) {
     if ((board & 0xaaaaaaaaaaaaaaaa) != 0) index += 1;
 
     return index;
-
-    /*
-     *Apparently that's faster than this?????:
-     *
-     *unsigned long index;
-     *_BitScanForward64(&index, board);
-     *return static_cast<Square>(index) * (board != 0);
-    */
 }
 
 // Gets the number of bits set
@@ -56,13 +61,57 @@ inline uint64_t SquareCount(BitBoard board) {
 }
 #endif
 
+// Removes the least significant bit (a single BLSR instruction with BMI1)
+inline BitBoard ClearLowestSquare(BitBoard board) {
+    return board & (board - 1);
+}
+
+// Iterates over the set bits of a BitBoard, from least to most significant:
+//
+// for (Square s : Squares(board))
+//     ...
+class Squares {
+public:
+    class Iterator {
+    public:
+        explicit Iterator(BitBoard board) : m_Board(board) {}
+
+        inline Square operator*() const { return GetSquare(m_Board); }
+        inline Iterator& operator++() { m_Board = ClearLowestSquare(m_Board); return *this; }
+        inline bool operator!=(const Iterator& other) const { return m_Board != other.m_Board; }
+    private:
+        BitBoard m_Board;
+    };
+
+    explicit Squares(BitBoard board) : m_Board(board) {}
+
+    inline Iterator begin() const { return Iterator(m_Board); }
+    inline Iterator end() const { return Iterator(0); }
+private:
+    BitBoard m_Board;
+};
+
+// Compiles a function twice, for baseline x86-64 and for x86-64-v3 (POPCNT, BMI1/2, LZCNT, AVX2),
+// and picks one when the program is loaded depending on the CPU (GCC function multiversioning)
+// Used on the functions with the hot bitboard loops, so everything they inline gets the faster
+// instructions without having to build for a specific CPU
+// GCC ignores it on templates, so templates are called from non-template functions marked
+// CHESS_MULTIVERSION_FLATTEN, which also inlines everything they call into each clone
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define CHESS_MULTIVERSION __attribute__((target_clones("default", "arch=x86-64-v3")))
+#define CHESS_MULTIVERSION_FLATTEN __attribute__((target_clones("default", "arch=x86-64-v3"), flatten))
+#else
+#define CHESS_MULTIVERSION
+#define CHESS_MULTIVERSION_FLATTEN
+#endif
+
 // Returns a BitBoard highlighting the file of the given square
-inline BitBoard BitBoardFile(Square square) {
+constexpr inline BitBoard BitBoardFile(Square square) {
     return 0x0101010101010101ull << (square & 0b00000111);  // Shifts the 'a' file to the file of the square
 }
 
 // Returns a BitBoard highlighting the rank of the given square
-inline BitBoard BitBoardRank(Square square) {
+constexpr inline BitBoard BitBoardRank(Square square) {
     return 0x00000000000000FFull << (square & 0b11111000);  // Shifts the first rank to the rank of the square
 }
 
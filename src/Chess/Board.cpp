@@ -4,6 +4,7 @@
 
 #include "Utility/StringParser.h"
 
+#include <algorithm>
 #include <sstream>
 
 static constexpr std::array<Piece, 64> s_StartBoard = {
@@ -39,6 +40,7 @@ void Board::Reset() {
     m_Board = s_StartBoard;
     m_PieceBitBoards = s_PieceBitBoards;
     m_ColourBitBoards = s_ColourBitBoards;
+    m_ControlledSquaresValid = 0;
 
     m_PlayerTurn = White;
     m_CastlingPath = s_CastlingPaths;
@@ -46,14 +48,27 @@ void Board::Reset() {
 
     m_HalfMoves = 0;
     m_FullMoves = 1;
+
+    m_Hash = CalculateHash();
+    m_PawnHash = CalculatePawnHash();
+    m_HashHistory.clear();
+
+    CalculateEvaluation();
 }
 
 void Board::FromFEN(const std::string& fen) {
     m_Board.fill(Piece::None);
     m_PieceBitBoards.fill(0);
     m_ColourBitBoards.fill(0);
+    m_ControlledSquaresValid = 0;
     m_CastlingPath.fill(0xFFFFFFFFFFFFFFFF);
 
+    // PlacePiece() adds up the totals from here
+    m_Material.fill(0);
+    m_MidGameScore.fill(0);
+    m_EndGameScore.fill(0);
+    m_Phase = 0;
+
     StringParser fenParser(fen);
 
     std::string_view board;
@@ -106,11 +121,19 @@ void Board::FromFEN(const std::string& fen) {
 
     std::string_view enPassantSquare;
     fenParser.Next(enPassantSquare);
-    if (enPassantSquare != "-")
-        m_EnPassantSquare = ToSquare(enPassantSquare[0], enPassantSquare[1]);
+    m_EnPassantSquare = enPassantSquare.size() == 2 ? ToSquare(enPassantSquare[0], enPassantSquare[1]) : 0;
+
+    // Only kept if a pawn can take, like in MakeMove(), so the position hashes the same as when it's reached by playing
+    const BitBoard takers = m_ColourBitBoards[m_PlayerTurn] & m_PieceBitBoards[Pawn];
+    if (m_EnPassantSquare != 0 && !(PseudoLegal::PawnAttack(m_EnPassantSquare, OppositeColour(m_PlayerTurn)) & takers))
+        m_EnPassantSquare = 0;
 
     fenParser.Next(m_HalfMoves);
     fenParser.Next(m_FullMoves);
+
+    m_Hash = CalculateHash();
+    m_PawnHash = CalculatePawnHash();
+    m_HashHistory.clear();
 }
 
 std::string Board::ToFEN() const {
@@ -177,346 +200,941 @@ std::string Board::ToFEN() const {
 }
 
 AlgebraicMove Board::Move(LongAlgebraicMove m) {
-    Piece piece = m_Board[m.SourceSquare];
-    Colour colour = GetColour(piece);
-    PieceType pieceType = GetPieceType(piece);
+    ValidateMove(m);
+
+    AlgebraicMove result = AnnotateMove(m);
+    MakeValidatedMove(m);
+
+    // If the move places the opponent in check (mate is only looked for then)
+    if (IsInCheck(m_PlayerTurn))
+        result.Flags |= HasLegalMoves(m_PlayerTurn) ? MoveFlag::Check : MoveFlag::Checkmate;
+
+    return result;
+}
 
-    if (!IsMoveLegal(m))
+LongAlgebraicMove Board::Move(AlgebraicMove m) {
+    const PackedMove move = FromAlgebraic(m);
+    MakeValidatedMove(move);
+
+    return move.ToLongAlgebraic();
+}
+
+void Board::Apply(PackedMove m) {
+    ValidateMove(m);
+    MakeValidatedMove(m);
+}
+
+void Board::ValidateMove(PackedMove m) const {
+    const Square source = m.SourceSquare();
+    const Square destination = m.DestinationSquare();
+    const Piece piece = m_Board[source];
+
+    if (piece == Piece::None || GetColour(piece) != m_PlayerTurn)
         throw IllegalMoveException(m.ToString());
-    
-    bool pawnMove = false;
-    bool capture = m_Board[m.DestinationSquare] != Piece::None;
-    Square newEnPassantSquare = 0;
-    uint8_t moveFlags = 0;
+
+    // Castling needs the full check, as the king can't pass through an attacked square
+    const bool castling = GetPieceType(piece) == King && abs(destination - source) == 2;
+    const BitBoard moves = castling ? GetPieceLegalMoves(source) : GetPseudoLegalMoves(source);
+    if (!(moves & (1ull << destination)))
+        throw IllegalMoveException(m.ToString());
+
+    // UnmakeMove() turns a piece back into a pawn if the move has a promotion, so only a promoting move can have one
+    const bool promoting = GetPieceType(piece) == Pawn && ((1ull << destination) & 0xFF000000000000FF);
+    if (promoting && (m.Promotion() == Pawn || m.Promotion() == King))
+        throw IllegalMoveException(m.ToString(), "Pawn must promote to another piece!");
+    if (!promoting && m.Promotion() != Pawn)
+        throw IllegalMoveException(m.ToString(), "Only a pawn on the last rank can promote!");
+}
+
+void Board::MakeValidatedMove(PackedMove m) {
+    UndoInfo undo;
+    MakeMove(m, undo);
+
+    // Cheaper than working out the pins before the move, as most moves are legal
+    if (IsInCheck(OppositeColour(m_PlayerTurn))) {
+        UnmakeMove(m, undo);
+        throw IllegalMoveException(m.ToString());
+    }
+
+    // The move can't be taken back, so the positions before a pawn move or capture are no longer needed
+    if (m_HalfMoves == 0)
+        m_HashHistory.clear();
+}
+
+AlgebraicMove Board::ToAlgebraic(PackedMove m) const {
+    AlgebraicMove result = AnnotateMove(m);
+
+    // Play the move on a copy to see if it checks or mates
+    Board after = *this;
+    UndoInfo undo;
+    after.MakeMove(m, undo);
+
+    if (after.IsInCheck(after.m_PlayerTurn))
+        result.Flags |= after.HasLegalMoves(after.m_PlayerTurn) ? MoveFlag::Check : MoveFlag::Checkmate;
+
+    return result;
+}
+
+AlgebraicMove Board::AnnotateMove(PackedMove m) const {
+    const Square source = m.SourceSquare();
+    const Square destination = m.DestinationSquare();
+    const Piece piece = m_Board[source];
+    const Colour colour = GetColour(piece);
+    const PieceType pieceType = GetPieceType(piece);
+
+    const bool enPassant = pieceType == Pawn && m_EnPassantSquare != 0 && destination == m_EnPassantSquare;
+    const bool capture = m_Board[destination] != Piece::None || enPassant;
+
+    MoveFlags flags = MoveFlag::Capture * capture;
+    Square specifier = source;
 
     if (pieceType == King) {
-        int direction = m.DestinationSquare - m.SourceSquare;  // Kingside or queenside
-
-        // If king is castling
-        if (abs(direction) == 2) {
-            Square rookSquare, newRookSquare;
-
-            if (direction < 0) {  // Queenside
-                rookSquare = m.SourceSquare - 4;
-                newRookSquare = m.DestinationSquare + 1;
-                moveFlags |= MoveFlag::CastleQueenSide;
-            } else {              // Kingside
-                rookSquare = m.SourceSquare + 3;
-                newRookSquare = m.DestinationSquare - 1;
-                moveFlags |= MoveFlag::CastleKingSide;
-            }
+        if (destination - source == 2)
+            flags |= MoveFlag::CastleKingSide;
+        else if (source - destination == 2)
+            flags |= MoveFlag::CastleQueenSide;
+    } else if (pieceType == Pawn) {
+        // For things like 'axb7', the 'a' is needed
+        specifier |= SpecifyFile * capture;
+
+        // The promotion flags have the same values as the piece types
+        if (m.Promotion() != Pawn)
+            flags |= m.Promotion();
+    } else {
+        // Other pieces of the same type that can also go to the destination
+        const MoveMasks masks = CalculateMoveMasks(colour);
+        BitBoard others = 0;
+        for (Square s : Squares(m_ColourBitBoards[colour] & m_PieceBitBoards[pieceType] & ~(1ull << source)))
+            if (GetPieceLegalMoves(s, masks, colour) & (1ull << destination))
+                others |= 1ull << s;
+
+        // Use the file if it is enough, then the rank, then both
+        if (others) {
+            if (!(others & BitBoardFile(source)))
+                specifier |= SpecifyFile;
+            else if (!(others & BitBoardRank(source)))
+                specifier |= SpecifyRank;
+            else
+                specifier |= SpecifyFileAndRank;
+        }
+    }
+
+    return { pieceType, destination, specifier, flags };
+}
+
+PackedMove Board::FromAlgebraic(const AlgebraicMove& m) const {
+    MoveList moves;
+    GenerateLegalMoves(moves);
+
+    // The king's destination when castling
+    Square castleDestination = INVALID_SQUARE;
+    if (m.Flags & MoveFlag::CastleKingSide)
+        castleDestination = FlipPerspective(G1, m_PlayerTurn);
+    else if (m.Flags & MoveFlag::CastleQueenSide)
+        castleDestination = FlipPerspective(C1, m_PlayerTurn);
+
+    const Square specifier = m.Specifier & RemoveSpecifierFlag;
+    const PieceType promotion = (PieceType)(m.Flags & 0b111);  // Pawn (0) if not promoting
+
+    PackedMove result;
+    size_t matches = 0;
 
-            // Only move the rook because the king will be moved below
-            RemovePiece(rookSquare);
-            PlacePiece(TypeAndColour(Rook, colour), newRookSquare);
+    for (PackedMove move : moves) {
+        const Square source = move.SourceSquare();
+        const PieceType pieceType = GetPieceType(m_Board[source]);
+
+        if (castleDestination != INVALID_SQUARE) {
+            if (pieceType != King || move.DestinationSquare() != castleDestination || source != FlipPerspective(E1, m_PlayerTurn))
+                continue;
+        } else {
+            if (pieceType != m.MovingPiece || move.DestinationSquare() != m.Destination || move.Promotion() != promotion)
+                continue;
+            if ((m.Specifier & SpecifyFile) && FileOf(source) != FileOf(specifier))
+                continue;
+            if ((m.Specifier & SpecifyRank) && RankOf(source) != RankOf(specifier))
+                continue;
+        }
+
+        result = move;
+        matches++;
+    }
+
+    if (matches != 1)
+        throw IllegalMoveException(AlgebraicMove(m).ToString());
+
+    return result;
+}
+
+void Board::MakeMove(PackedMove m, UndoInfo& undo) {
+    const Square source = m.SourceSquare();
+    const Square destination = m.DestinationSquare();
+    const PieceType promotion = m.Promotion();
+    const Colour colour = m_PlayerTurn;
+    Piece piece = m_Board[source];
+    const PieceType pieceType = GetPieceType(piece);
+
+    undo.Captured = m_Board[destination];
+    undo.EnPassantSquare = m_EnPassantSquare;
+    undo.HalfMoves = m_HalfMoves;
+    undo.CastlingRights = GetCastlingRights();
+
+    m_HashHistory.push_back(m_Hash);
+
+    bool capture = undo.Captured != Piece::None;
+    Square newEnPassantSquare = 0;
+
+    if (pieceType == King) {
+        int direction = destination - source;  // Kingside or queenside
+
+        // If king is castling, only move the rook because the king is moved below
+        if (direction == 2) {
+            RemovePiece(source + 3);
+            PlacePiece(TypeAndColour(Rook, colour), destination - 1);
+        } else if (direction == -2) {
+            RemovePiece(source - 4);
+            PlacePiece(TypeAndColour(Rook, colour), destination + 1);
         }
 
         m_CastlingPath[colour | KingSide] = NO_CASTLE;
         m_CastlingPath[colour | QueenSide] = NO_CASTLE;
     } else if (pieceType == Pawn) {
-        pawnMove = true;
-        if (m.SourceSquare - m.DestinationSquare == 16) {  // If black pushed pawn two squares
-            newEnPassantSquare = m.DestinationSquare + 8;
-        } else if (m.DestinationSquare - m.SourceSquare == 16) {  // If white pushed pawn two squares
-            newEnPassantSquare = m.DestinationSquare - 8;
-        } else if (m.DestinationSquare == m_EnPassantSquare) {  // If taking en passant
-            // Remove the en passant-ed pawn
-            if (colour == White)
-                RemovePiece(m.DestinationSquare - 8);
-            else
-                RemovePiece(m.DestinationSquare + 8);
-
+        if (abs(destination - source) == 16) {  // If pawn was pushed two squares
+            // Only set if an enemy pawn can take, so positions that only differ by a useless en passant square hash the same (for repetitions)
+            const Square skipped = (source + destination) / 2;
+            if (PseudoLegal::PawnAttack(skipped, colour) & m_ColourBitBoards[OppositeColour(colour)] & m_PieceBitBoards[Pawn])
+                newEnPassantSquare = skipped;
+        } else if (m_EnPassantSquare != 0 && destination == m_EnPassantSquare) {  // If taking en passant
+            RemovePiece(colour == White ? destination - 8 : destination + 8);
             capture = true;
-        } else if ((1ull << m.DestinationSquare) & 0xFF000000000000FF) {  // If pawn is promoting
-            if (m.Promotion == Pawn || m.Promotion == King)
-                throw IllegalMoveException("Pawn must promote to another piece!");
-
-            piece = TypeAndColour(m.Promotion, colour);
+        } else if ((1ull << destination) & 0xFF000000000000FF) {  // If pawn is promoting
+            piece = TypeAndColour(promotion, colour);
         }
     }
 
-    m_EnPassantSquare = newEnPassantSquare;
-
     // If a rook moves or is captured, remove castling rights accordingly
-    if (m.SourceSquare == A1 || m.DestinationSquare == A1)
+    if (source == A1 || destination == A1)
         m_CastlingPath[White | QueenSide] = NO_CASTLE;
-    else if (m.SourceSquare == H1 || m.DestinationSquare == H1)
+    if (source == H1 || destination == H1)
         m_CastlingPath[White | KingSide] = NO_CASTLE;
-    else if (m.SourceSquare == A8 || m.DestinationSquare == A8)
+    if (source == A8 || destination == A8)
         m_CastlingPath[Black | QueenSide] = NO_CASTLE;
-    else if (m.SourceSquare == H8 || m.DestinationSquare == H8)
+    if (source == H8 || destination == H8)
         m_CastlingPath[Black | KingSide] = NO_CASTLE;
 
-    m_HalfMoves = (m_HalfMoves + 1) * !(pawnMove || capture);  // Increments if no pawn move or capture, sets to 0 otherwise
-    m_FullMoves += m_PlayerTurn == Black;
+    m_Hash ^= Zobrist::CastlingKey(undo.CastlingRights ^ GetCastlingRights());
 
-    //
-    // Figure out the algebraic notation
-    //
+    RemovePiece(source);
+    RemovePiece(destination);
+    PlacePiece(piece, destination);
 
-    Square specifier = m.SourceSquare;
+    SetEnPassantSquare(newEnPassantSquare);
+    m_HalfMoves = (m_HalfMoves + 1) * !(pieceType == Pawn || capture);
+    m_FullMoves += colour == Black;
+    SwitchPlayerTurn();
+}
 
-    if (pieceType == Pawn) {
-        // For things like 'axb7', the 'a' is needed
-        specifier |= SpecifyFile * capture;
-    } else if (pieceType != King) {
-        // Other pieces that can go to the same square
-        BitBoard possiblePieces = m_ColourBitBoards[colour] & m_PieceBitBoards[pieceType];
-        const BitBoard allPieces = m_ColourBitBoards[White] | m_ColourBitBoards[Black];
-        switch (pieceType) {
-            case Knight: possiblePieces &= PseudoLegal::KnightAttack(m.DestinationSquare); break;
-            case Bishop: possiblePieces &= PseudoLegal::BishopAttack(m.DestinationSquare, allPieces); break;
-            case Rook:   possiblePieces &= PseudoLegal::RookAttack(m.DestinationSquare, allPieces); break;
-            case Queen:  possiblePieces &= PseudoLegal::QueenAttack(m.DestinationSquare, allPieces); break;
-            default: possiblePieces = 0;
+void Board::UnmakeMove(PackedMove m, const UndoInfo& undo) {
+    const Square source = m.SourceSquare();
+    const Square destination = m.DestinationSquare();
+    const PieceType promotion = m.Promotion();
+    const Colour colour = OppositeColour(m_PlayerTurn);  // The player who made the move
+    Piece piece = m_Board[destination];
+
+    // Turn a promoted piece back into a pawn
+    if (promotion != Pawn && GetPieceType(piece) == promotion && ((1ull << destination) & 0xFF000000000000FF))
+        piece = TypeAndColour(Pawn, colour);
+
+    RemovePiece(destination);
+    PlacePiece(piece, source);
+
+    if (undo.Captured != Piece::None)
+        PlacePiece(undo.Captured, destination);
+
+    if (GetPieceType(piece) == King) {
+        int direction = destination - source;
+
+        // Put the rook back in the corner
+        if (direction == 2) {
+            RemovePiece(destination - 1);
+            PlacePiece(TypeAndColour(Rook, colour), source + 3);
+        } else if (direction == -2) {
+            RemovePiece(destination + 1);
+            PlacePiece(TypeAndColour(Rook, colour), source - 4);
+        }
+    } else if (GetPieceType(piece) == Pawn && undo.EnPassantSquare != 0 && destination == undo.EnPassantSquare) {
+        // Put back the pawn taken en passant
+        PlacePiece(TypeAndColour(Pawn, m_PlayerTurn), colour == White ? destination - 8 : destination + 8);
+    }
+
+    m_Hash ^= Zobrist::CastlingKey(undo.CastlingRights ^ GetCastlingRights());
+    for (size_t i = 0; i < m_CastlingPath.size(); i++)
+        m_CastlingPath[i] = (undo.CastlingRights & (1 << i)) ? s_CastlingPaths[i] : NO_CASTLE;
+
+    SetEnPassantSquare(undo.EnPassantSquare);
+    m_HalfMoves = undo.HalfMoves;
+    m_FullMoves -= colour == Black;
+    SwitchPlayerTurn();
+
+    m_HashHistory.pop_back();
+}
+
+uint8_t Board::GetCastlingRights() const {
+    uint8_t rights = 0;
+    for (size_t i = 0; i < m_CastlingPath.size(); i++)
+        rights |= (m_CastlingPath[i] != NO_CASTLE) << i;
+
+    return rights;
+}
+
+uint64_t Board::CalculateHash() const {
+    uint64_t hash = 0;
+
+    for (Square s = 0; s < m_Board.size(); s++)
+        if (m_Board[s] != Piece::None)
+            hash ^= Zobrist::PieceKey(m_Board[s], s);
+
+    hash ^= Zobrist::CastlingKey(GetCastlingRights());
+    hash ^= Zobrist::EnPassantKey(m_EnPassantSquare);
+    hash ^= Zobrist::PlayerTurnKey() * (m_PlayerTurn == Black);
+
+    return hash;
+}
+
+uint64_t Board::CalculatePawnHash() const {
+    uint64_t hash = 0;
+
+    for (Square s : Squares(m_PieceBitBoards[Pawn]))
+        hash ^= Zobrist::PieceKey(m_Board[s], s);
+
+    return hash;
+}
+
+void Board::CalculateEvaluation() {
+    m_Material.fill(0);
+    m_MidGameScore.fill(0);
+    m_EndGameScore.fill(0);
+    m_Phase = 0;
+
+    for (Square s : Squares(m_ColourBitBoards[White] | m_ColourBitBoards[Black])) {
+        const Piece p = m_Board[s];
+        m_Material[GetColour(p)] += SEEValues[GetPieceType(p)];
+        m_MidGameScore[GetColour(p)] += Evaluation::MidGame(p, s);
+        m_EndGameScore[GetColour(p)] += Evaluation::EndGame(p, s);
+        m_Phase += Evaluation::PhaseWeight(p);
+    }
+}
+
+CHESS_MULTIVERSION_FLATTEN bool Board::HasLegalMoves(Colour colour) const {
+    return colour == White ? HasLegalMoves<White>() : HasLegalMoves<Black>();
+}
+
+// Stops at the first move found, trying the cheapest sets of moves first
+// The king is tried last because its moves need the squares controlled by the enemy
+template <Colour Us>
+bool Board::HasLegalMoves() const {
+    constexpr Colour Them = OppositeColour(Us);
+
+    const MoveMasks masks = CalculateMoveMasks<Us>();
+
+    const BitBoard allPieces = m_ColourBitBoards[White] | m_ColourBitBoards[Black];
+    const BitBoard ourPieces = m_ColourBitBoards[Us];
+    const Square kingSquare = GetSquare(ourPieces & m_PieceBitBoards[King]);
+
+    // If it is double check, only the king can move
+    if (ClearLowestSquare(masks.Checkers) == 0) {
+        const BitBoard targets = ~ourPieces & masks.CheckMask;
+        const BitBoard pinned = masks.RookPin | masks.BishopPin;
+
+        const PawnTargets pawnTargets = GetPawnTargets<Us>(masks);
+        if (pawnTargets.SinglePushes | pawnTargets.WestCaptures | pawnTargets.EastCaptures)
+            return true;
+
+        for (Square source : Squares(ourPieces & m_PieceBitBoards[Knight] & ~pinned))
+            if (PseudoLegal::KnightAttack(source) & targets)
+                return true;
+
+        for (Square source : Squares(ourPieces & (m_PieceBitBoards[Bishop] | m_PieceBitBoards[Queen]) & ~masks.RookPin)) {
+            BitBoard legalMoves = PseudoLegal::BishopAttack(source, allPieces) & targets;
+            if ((1ull << source) & masks.BishopPin)
+                legalMoves &= PseudoLegal::LineThrough(kingSquare, source);
+            if (legalMoves)
+                return true;
         }
 
-        // Loop through the possible pieces, remove the ones that can't move (pinned)
-        for (BitBoard b = possiblePieces; b != 0; b &= b - 1) {
-            if (!GetPieceLegalMoves(GetSquare(b)))
-                possiblePieces &= ~(1ull << GetSquare(b));
+        for (Square source : Squares(ourPieces & (m_PieceBitBoards[Rook] | m_PieceBitBoards[Queen]) & ~masks.BishopPin)) {
+            BitBoard legalMoves = PseudoLegal::RookAttack(source, allPieces) & targets;
+            if ((1ull << source) & masks.RookPin)
+                legalMoves &= PseudoLegal::LineThrough(kingSquare, source);
+            if (legalMoves)
+                return true;
         }
 
-        // Map everything to the first rank and check if there is more than one piece
-        if (SquareCount((possiblePieces * 0x0101010101010101) >> 56) > 1)
-            specifier |= SpecifyFile;
+        // A double push only adds a move when the single push can't be played (blocking a check)
+        if (pawnTargets.DoublePushes)
+            return true;
 
-        // On the same file
-        if (BitBoardFile(m.SourceSquare) & possiblePieces & ~(1ull << m.SourceSquare))
-            specifier |= SpecifyRank;
+        if (m_EnPassantSquare != 0) {
+            for (Square source : Squares(PseudoLegal::PawnAttack<Them>(m_EnPassantSquare) & ourPieces & m_PieceBitBoards[Pawn]))
+                if (IsEnPassantLegal<Us>(source, masks))
+                    return true;
+        }
     }
 
-    // Next player's turn
-    m_PlayerTurn = OppositeColour(m_PlayerTurn);
+    return GetKingLegalMoves<Us>(kingSquare, AttackedBy(Them)) != 0;
+}
+
+GameStatus Board::Status() const {
+    // Only needs the piece bitboards, and no mate is possible with this material
+    if (IsInsufficientMaterial())
+        return GameStatus::InsufficientMaterial;
 
-    // Move the piece
-    RemovePiece(m.SourceSquare);
-    // We have to erase the piece from the bit boards before we capture it
-    RemovePiece(m.DestinationSquare);
-    PlacePiece(piece, m.DestinationSquare);
+    // Mate takes priority over the fifty move rule
+    if (!HasLegalMoves(m_PlayerTurn))
+        return IsInCheck(m_PlayerTurn) ? GameStatus::Checkmate : GameStatus::Stalemate;
 
-    // If the current move places the opponent in check
-    bool isCheck = m_PieceBitBoards[King] & m_ColourBitBoards[m_PlayerTurn] & ControlledSquares(colour);
-    bool isMate = !HasLegalMoves(m_PlayerTurn) && isCheck;
-    
-    moveFlags |= MoveFlag::Check * isCheck;
-    moveFlags |= MoveFlag::Checkmate * isMate;
-    moveFlags |= MoveFlag::Capture * capture;
+    if (m_HalfMoves >= 100)
+        return GameStatus::FiftyMove;
 
-    return { pieceType, m.DestinationSquare, specifier, moveFlags };
+    if (IsRepetition(3))
+        return GameStatus::Repetition;
+
+    return GameStatus::Ongoing;
 }
 
-LongAlgebraicMove Board::Move(AlgebraicMove m) {
-    Square source;
-    PieceType Promotion = Pawn;
+bool Board::IsRepetition(int32_t count) const {
+    // Only positions since the last pawn move or capture can be the same as this one,
+    // and only the ones with the same player to move (so every other one, from 4 half moves back)
+    const size_t size = m_HashHistory.size();
+    const size_t reversible = std::min((size_t)m_HalfMoves, size);
 
-    Colour opponentColour = OppositeColour(m_PlayerTurn);
+    int32_t found = 1;  // The current position
+    for (size_t back = 4; back <= reversible; back += 2)
+        if (m_HashHistory[size - back] == m_Hash && ++found >= count)
+            return true;
 
-	if (m.Flags & (MoveFlag::CastleKingSide | MoveFlag::CastleQueenSide)) {
-        Square kingStart = E1 ^ (m_PlayerTurn * 0b00111000);
-        Square rookStart = H1 ^ (m_PlayerTurn * 0b00111000);
-		Square kingDestination, rookDestination;
+    return found >= count;
+}
 
-        if (m.Flags & MoveFlag::CastleKingSide) {
-            kingDestination = G1 ^ (m_PlayerTurn * 0b00111000);
-            rookDestination = F1 ^ (m_PlayerTurn * 0b00111000);
-        } else {
-            kingDestination = C1 ^ (m_PlayerTurn * 0b00111000);
-            rookDestination = D1 ^ (m_PlayerTurn * 0b00111000);
+bool Board::IsInsufficientMaterial() const {
+    constexpr BitBoard LightSquares = 0x55AA55AA55AA55AA;
+
+    if (m_PieceBitBoards[Pawn] | m_PieceBitBoards[Rook] | m_PieceBitBoards[Queen])
+        return false;
+
+    // King against king and a minor piece (or a bare king)
+    const BitBoard minors = m_PieceBitBoards[Knight] | m_PieceBitBoards[Bishop];
+    if (ClearLowestSquare(minors) == 0)
+        return true;
+
+    // Any number of bishops, if they are all on squares of the same colour
+    const BitBoard bishops = m_PieceBitBoards[Bishop];
+    return m_PieceBitBoards[Knight] == 0 && (!(bishops & LightSquares) || !(bishops & ~LightSquares));
+}
+
+BitBoard Board::GetPieceLegalMoves(Square piece) const {
+    Colour playerColour = GetColour(m_Board[piece]);
+
+    if (playerColour != m_PlayerTurn)
+        return 0;
+
+    if (playerColour == White) {
+        if (GetPieceType(m_Board[piece]) == King)
+            return GetKingLegalMoves<White>(piece, AttackedBy(Black));
+        return GetPieceLegalMoves<White>(piece, CalculateMoveMasks<White>());
+    }
+
+    if (GetPieceType(m_Board[piece]) == King)
+        return GetKingLegalMoves<Black>(piece, AttackedBy(White));
+    return GetPieceLegalMoves<Black>(piece, CalculateMoveMasks<Black>());
+}
+
+CHESS_MULTIVERSION_FLATTEN void Board::GenerateLegalMoves(MoveList& moves) const {
+    if (m_PlayerTurn == White)
+        GenerateMoves<White, AllMoves>(moves);
+    else
+        GenerateMoves<Black, AllMoves>(moves);
+}
+
+CHESS_MULTIVERSION_FLATTEN void Board::GenerateCaptures(MoveList& moves) const {
+    const size_t first = moves.Size();
+
+    if (m_PlayerTurn == White)
+        GenerateMoves<White, CaptureMoves>(moves);
+    else
+        GenerateMoves<Black, CaptureMoves>(moves);
+
+    // Most valuable victim first, then least valuable attacker (promotions count the piece gained)
+    // An insertion sort, since there are only a few captures
+    auto score = [this](PackedMove m) {
+        constexpr int32_t s_Values[] = { 1, 3, 3, 5, 9, 0, 0, 0 };  // Indexed by PieceType, None gives 0
+
+        // En passant lands on an empty square, but takes a pawn
+        const PieceType attacker = GetPieceType(m_Board[m.SourceSquare()]);
+        const bool enPassant = attacker == Pawn && m_EnPassantSquare != 0 && m.DestinationSquare() == m_EnPassantSquare;
+        const PieceType victim = enPassant ? Pawn : GetPieceType(m_Board[m.DestinationSquare()]);
+        const int32_t promotion = m.Promotion() == Pawn ? 0 : s_Values[m.Promotion()] - 1;
+        return (s_Values[victim] + promotion) * 8 - attacker;
+    };
+
+    for (size_t i = first + 1; i < moves.Size(); i++) {
+        const PackedMove move = moves[i];
+        const int32_t moveScore = score(move);
+
+        size_t j = i;
+        for (; j > first && score(moves[j - 1]) < moveScore; j--)
+            moves[j] = moves[j - 1];
+        moves[j] = move;
+    }
+}
+
+CHESS_MULTIVERSION_FLATTEN void Board::GenerateQuietMoves(MoveList& moves) const {
+    if (m_PlayerTurn == White)
+        GenerateMoves<White, QuietMoves>(moves);
+    else
+        GenerateMoves<Black, QuietMoves>(moves);
+}
+
+CHESS_MULTIVERSION_FLATTEN void Board::GenerateEvasions(MoveList& moves) const {
+    if (m_PlayerTurn == White)
+        GenerateMoves<White, Evasions>(moves);
+    else
+        GenerateMoves<Black, Evasions>(moves);
+}
+
+template <Colour Us, Board::MoveType Type>
+void Board::GenerateMoves(MoveList& moves) const {
+    constexpr Colour Them = OppositeColour(Us);
+    constexpr BitBoard LastRank = Us == White ? 0xFF00000000000000 : 0x00000000000000FF;
+
+    const MoveMasks masks = CalculateMoveMasks<Us>();
+
+    if constexpr (Type == Evasions) {
+        if (masks.Checkers == 0)
+            return;
+    }
+
+    const BitBoard allPieces = m_ColourBitBoards[White] | m_ColourBitBoards[Black];
+    const BitBoard ourPieces = m_ColourBitBoards[Us];
+    const BitBoard king = ourPieces & m_PieceBitBoards[King];
+    const Square kingSquare = GetSquare(king);
+
+    // The squares the moves of this type may go to (before the check mask, which the king ignores)
+    BitBoard destinations = ~ourPieces;
+    if constexpr (Type == CaptureMoves)
+        destinations = m_ColourBitBoards[Them];
+    else if constexpr (Type == QuietMoves)
+        destinations = ~allPieces;
+
+    for (Square destination : Squares(GetKingLegalMoves<Us>(kingSquare, AttackedBy(Them)) & destinations))
+        moves.Add({ kingSquare, destination });
+
+    // If it is double check, only the king can move
+    if (ClearLowestSquare(masks.Checkers) != 0)
+        return;
+
+    const BitBoard targets = destinations & masks.CheckMask;
+
+    //
+    // Pawns, all at once
+    // Every promotion counts as a capture, so the captures are all the tactical moves
+    //
+
+    // Pawns reaching the last rank add one move for each promotion
+    auto addPawnMoves = [&moves](BitBoard pawnDestinations, int offset) {
+        for (Square destination : Squares(pawnDestinations & LastRank)) {
+            const Square source = destination - offset;
+            moves.Add({ source, destination, Queen });
+            moves.Add({ source, destination, Rook });
+            moves.Add({ source, destination, Bishop });
+            moves.Add({ source, destination, Knight });
         }
-        
-        if (IsMoveLegal({ kingStart, kingDestination })) {
-            // Move the king
-            RemovePiece(kingStart);
-            PlacePiece(TypeAndColour(King, m_PlayerTurn), kingDestination);
-
-            // Move the rook
-            RemovePiece(rookStart);
-            PlacePiece(TypeAndColour(Rook, m_PlayerTurn), rookDestination);
-
-            m_PlayerTurn = opponentColour;
-            return { kingStart, kingDestination, Promotion };
+
+        for (Square destination : Squares(pawnDestinations & ~LastRank))
+            moves.Add({ (Square)(destination - offset), destination });
+    };
+
+    const PawnTargets pawnTargets = GetPawnTargets<Us>(masks);
+
+    if constexpr (Type == CaptureMoves) {
+        addPawnMoves(pawnTargets.SinglePushes & LastRank, PseudoLegal::PawnPushOffset<Us>);
+    } else if constexpr (Type == QuietMoves) {
+        addPawnMoves(pawnTargets.SinglePushes & ~LastRank, PseudoLegal::PawnPushOffset<Us>);
+        addPawnMoves(pawnTargets.DoublePushes, 2 * PseudoLegal::PawnPushOffset<Us>);
+    } else {
+        addPawnMoves(pawnTargets.SinglePushes, PseudoLegal::PawnPushOffset<Us>);
+        addPawnMoves(pawnTargets.DoublePushes, 2 * PseudoLegal::PawnPushOffset<Us>);
+    }
+
+    if constexpr (Type != QuietMoves) {
+        addPawnMoves(pawnTargets.WestCaptures, PseudoLegal::PawnWestOffset<Us>);
+        addPawnMoves(pawnTargets.EastCaptures, PseudoLegal::PawnEastOffset<Us>);
+
+        // The pawns that could take en passant are the ones a pawn of the other colour
+        // on the en passant square would attack
+        if (m_EnPassantSquare != 0) {
+            for (Square source : Squares(PseudoLegal::PawnAttack<Them>(m_EnPassantSquare) & ourPieces & m_PieceBitBoards[Pawn]))
+                if (IsEnPassantLegal<Us>(source, masks))
+                    moves.Add({ source, m_EnPassantSquare });
         }
+    }
 
-        throw IllegalMoveException(m.ToString());
-	} else if (m.MovingPiece == Pawn) {
-        int8_t direction = m_PlayerTurn == White ? 8 : -8;
-        if (m.Flags & MoveFlag::Capture) {
-            BitBoard possiblePieces = PseudoLegal::PawnAttack(m.Destination, opponentColour);
-            Square file = FileOf(m.Specifier);
-            source = GetSquare(possiblePieces & BitBoardFile(file));
-            
-            // Remove the en passant-ed pawn if taking en passant
-            if (m.Destination == m_EnPassantSquare)
-                RemovePiece(m.Destination - direction);
-        } else {  // Pawn push
-            source = m.Destination - direction;
-
-            // If the pawn ends up on the 4th or 5th rank
-            // and there is no pawn 1 square at it's rear
-            // it has been pushed two squares
-            // which this comment makes clear
-            const bool middle = RankOf(m.Destination) == (3 + m_PlayerTurn);  // If it is on the 4th or 5th rank (according to colour)
-            if (middle && GetPieceType(m_Board[source]) != Pawn) {
-                m_EnPassantSquare = source;
-                source -= direction;  // Move 'source' further back one square
+    //
+    // Pieces
+    // Pinned knights can never move, and sliders pinned on a line can only move along it
+    //
+
+    const BitBoard pinned = masks.RookPin | masks.BishopPin;
+
+    for (Square source : Squares(ourPieces & m_PieceBitBoards[Knight] & ~pinned))
+        for (Square destination : Squares(PseudoLegal::KnightAttack(source) & targets))
+            moves.Add({ source, destination });
+
+    for (Square source : Squares(ourPieces & (m_PieceBitBoards[Bishop] | m_PieceBitBoards[Queen]) & ~masks.RookPin)) {
+        BitBoard legalMoves = PseudoLegal::BishopAttack(source, allPieces) & targets;
+        if ((1ull << source) & masks.BishopPin)
+            legalMoves &= PseudoLegal::LineThrough(kingSquare, source);
+
+        for (Square destination : Squares(legalMoves))
+            moves.Add({ source, destination });
+    }
+
+    for (Square source : Squares(ourPieces & (m_PieceBitBoards[Rook] | m_PieceBitBoards[Queen]) & ~masks.BishopPin)) {
+        BitBoard legalMoves = PseudoLegal::RookAttack(source, allPieces) & targets;
+        if ((1ull << source) & masks.RookPin)
+            legalMoves &= PseudoLegal::LineThrough(kingSquare, source);
+
+        for (Square destination : Squares(legalMoves))
+            moves.Add({ source, destination });
+    }
+}
+
+void Board::GeneratePseudoLegalMoves(MoveList& moves) const {
+    const BitBoard lastRank = m_PlayerTurn == White ? 0xFF00000000000000 : 0x00000000000000FF;
+    const BitBoard allPieces = m_ColourBitBoards[White] | m_ColourBitBoards[Black];
+
+    for (Square source : Squares(m_ColourBitBoards[m_PlayerTurn])) {
+        const BitBoard destinations = GetPseudoLegalMoves(source);
+
+        if (GetPieceType(m_Board[source]) == Pawn) {
+            for (Square destination : Squares(destinations & lastRank)) {
+                moves.Add({ source, destination, Queen });
+                moves.Add({ source, destination, Rook });
+                moves.Add({ source, destination, Bishop });
+                moves.Add({ source, destination, Knight });
             }
+
+            for (Square destination : Squares(destinations & ~lastRank))
+                moves.Add({ source, destination });
+
+            continue;
         }
-	} else {  // Normal piece
-        // All of the same type of piece that can go to the same square
-        BitBoard possiblePieces = m_PieceBitBoards[m.MovingPiece] & m_ColourBitBoards[m_PlayerTurn];
-
-		const BitBoard allPieces = m_ColourBitBoards[White] | m_ColourBitBoards[Black];
-		switch (m.MovingPiece) {
-            case Knight: possiblePieces &= PseudoLegal::KnightAttack(m.Destination); break;
-            case Bishop: possiblePieces &= PseudoLegal::BishopAttack(m.Destination, allPieces); break;
-            case Rook:   possiblePieces &= PseudoLegal::RookAttack(m.Destination, allPieces); break;
-            case Queen:  possiblePieces &= PseudoLegal::QueenAttack(m.Destination, allPieces); break;
-            default: possiblePieces = 0;
-        }
-        
-        // Prune the pieces that are not specified
-        if (m.Specifier & SpecifyFile)
-            possiblePieces &= BitBoardFile(FileOf(m.Specifier));
-
-        if (m.Specifier & SpecifyRank)
-            possiblePieces &= BitBoardFile(RankOf(m.Specifier));
-
-        // Prune the pinned pieces
-        for (BitBoard b = possiblePieces; b != 0; b &= b - 1) {
-            if (!GetPieceLegalMoves(GetSquare(b)))
-                possiblePieces &= ~(1ull << GetSquare(b));
+
+        for (Square destination : Squares(destinations))
+            moves.Add({ source, destination });
+
+        // Whether the king passes through check is left to IsLegal()
+        // (a path without the rights is all ones, so it always has a piece on it)
+        if (GetPieceType(m_Board[source]) == King) {
+            const BitBoard otherPieces = allPieces & ~(1ull << source);
+            if (!(otherPieces & m_CastlingPath[m_PlayerTurn | KingSide]))
+                moves.Add({ source, (Square)(source + 2) });
+            if (!(otherPieces & m_CastlingPath[m_PlayerTurn | QueenSide]))
+                moves.Add({ source, (Square)(source - 2) });
         }
+    }
+}
 
-        if (SquareCount(possiblePieces) != 1)
-            throw IllegalMoveException("None, or more than two pieces can move to the same square!");
+BitBoard Board::PinnedPieces() const {
+    const Colour them = OppositeColour(m_PlayerTurn);
 
-        source = GetSquare(possiblePieces);
-	}
-    
-    if (!IsMoveLegal({ source, m.Destination }))
-        throw IllegalMoveException(m.ToString());
+    const BitBoard allPieces = m_ColourBitBoards[White] | m_ColourBitBoards[Black];
+    const BitBoard ourPieces = m_ColourBitBoards[m_PlayerTurn];
+    const Square kingSquare = GetSquare(ourPieces & m_PieceBitBoards[King]);
 
-    Piece piece = m_Board[source];
-    // Move the piece
-    RemovePiece(source);
-    // We have to erase the piece from the bit boards before we capture it
-    RemovePiece(m.Destination);
-    PlacePiece(piece, m.Destination);
+    // The enemy sliders that would attack the king if our pieces weren't there
+    const BitBoard pinners = m_ColourBitBoards[them]
+        & ((PseudoLegal::BishopAttack(kingSquare, allPieces & ~ourPieces) & (m_PieceBitBoards[Bishop] | m_PieceBitBoards[Queen]))
+        | (PseudoLegal::RookAttack(kingSquare, allPieces & ~ourPieces) & (m_PieceBitBoards[Rook] | m_PieceBitBoards[Queen])));
 
-    m_PlayerTurn = opponentColour;
+    // A piece is pinned if it's the only piece between the king and a pinner
+    BitBoard pinned = 0;
+    for (Square pinner : Squares(pinners)) {
+        const BitBoard between = PseudoLegal::Between(kingSquare, pinner) & allPieces;
+        if (between && ClearLowestSquare(between) == 0)
+            pinned |= between & ourPieces;
+    }
 
-    return { source, m.Destination, Promotion };
+    return pinned;
 }
 
-bool Board::HasLegalMoves(Colour colour) {
-    for (Square s = 0; s < m_Board.size(); s++)
-        if (GetColour(m_Board[s]) == colour)
-            if (GetPieceLegalMoves(s) != 0)
-                return true;
+BitBoard Board::Checkers() const {
+    const BitBoard king = m_ColourBitBoards[m_PlayerTurn] & m_PieceBitBoards[King];
+    return AttackersTo(GetSquare(king)) & m_ColourBitBoards[OppositeColour(m_PlayerTurn)];
+}
+
+bool Board::IsLegal(PackedMove m, BitBoard pinned, BitBoard checkers) const {
+    const Colour them = OppositeColour(m_PlayerTurn);
+
+    const Square source = m.SourceSquare();
+    const Square destination = m.DestinationSquare();
+    const PieceType piece = GetPieceType(m_Board[source]);
+
+    const BitBoard allPieces = m_ColourBitBoards[White] | m_ColourBitBoards[Black];
+    const BitBoard enemyPieces = m_ColourBitBoards[them];
 
-    return false;
+    if (piece == King) {
+        // Castling can't start in check, and the king can't pass through an attacked square
+        if (abs(destination - source) == 2) {
+            if (checkers)
+                return false;
+
+            return !(AttackedBy(them) & (PseudoLegal::Between(source, destination) | (1ull << destination)));
+        }
+
+        // The king is taken off the board, so sliders see through the square it leaves
+        return !(AttackersTo(destination, allPieces ^ (1ull << source)) & enemyPieces);
+    }
+
+    const Square kingSquare = GetSquare(m_ColourBitBoards[m_PlayerTurn] & m_PieceBitBoards[King]);
+
+    // En passant removes two pawns from their squares, which can uncover a slider on the king
+    // Playing it out on the occupancy covers that and any check at once
+    if (piece == Pawn && destination == m_EnPassantSquare && m_EnPassantSquare != 0) {
+        const BitBoard captured = 1ull << (m_EnPassantSquare + (m_PlayerTurn == White ? -8 : 8));
+        const BitBoard occupied = (allPieces & ~((1ull << source) | captured)) | (1ull << destination);
+
+        return !(AttackersTo(kingSquare, occupied) & enemyPieces & ~captured);
+    }
+
+    // In check, the move must take the checker or block it (and nothing but the king can escape double check)
+    if (checkers) {
+        if (ClearLowestSquare(checkers) != 0)
+            return false;
+
+        const Square checker = GetSquare(checkers);
+        if (!((PseudoLegal::Between(kingSquare, checker) | checkers) & (1ull << destination)))
+            return false;
+    }
+
+    // A pinned piece can only move along the line through the king and itself
+    return !((1ull << source) & pinned) || (PseudoLegal::LineThrough(kingSquare, source) & (1ull << destination));
 }
 
-BitBoard Board::GetPieceLegalMoves(Square piece) {
-    Colour playerColour = GetColour(m_Board[piece]);
-    Colour enemyColour = OppositeColour(playerColour);
+CHESS_MULTIVERSION_FLATTEN size_t Board::CountLegalMoves() const {
+    return m_PlayerTurn == White ? CountLegalMoves<White>() : CountLegalMoves<Black>();
+}
 
-    if (enemyColour == m_PlayerTurn)
-        return 0;
+// The same as GenerateMoves<Us, AllMoves>(), but counts the destinations instead of adding them
+template <Colour Us>
+CHESS_MULTIVERSION_FLATTEN size_t Board::CountLegalMoves() const {
+    constexpr Colour Them = OppositeColour(Us);
+    constexpr BitBoard LastRank = Us == White ? 0xFF00000000000000 : 0x00000000000000FF;
+
+    const MoveMasks masks = CalculateMoveMasks<Us>();
+
+    const BitBoard allPieces = m_ColourBitBoards[White] | m_ColourBitBoards[Black];
+    const BitBoard ourPieces = m_ColourBitBoards[Us];
+    const Square kingSquare = GetSquare(ourPieces & m_PieceBitBoards[King]);
 
-    BitBoard allPieces = m_ColourBitBoards[White] | m_ColourBitBoards[Black];
-    BitBoard king = m_ColourBitBoards[playerColour] & m_PieceBitBoards[King];
-    BitBoard enemyPieces = m_ColourBitBoards[enemyColour];
+    size_t count = SquareCount(GetKingLegalMoves<Us>(kingSquare, AttackedBy(Them)));
 
-    if (GetPieceType(m_Board[piece]) == King) {
-        BitBoard legalMoves = GetPseudoLegalMoves(piece);
-        BitBoard controlledSquares = ControlledSquares(enemyColour);
+    // If it is double check, only the king can move
+    if (ClearLowestSquare(masks.Checkers) != 0)
+        return count;
 
-        // Deals with castling
-        if (!((allPieces & ~king) & m_CastlingPath[playerColour | KingSide]) && !(controlledSquares & m_CastlingPath[playerColour | KingSide]))
-            legalMoves |= 0x40ull << (playerColour == White ? 0 : 56);
-        if (!((allPieces & ~king) & m_CastlingPath[playerColour | QueenSide]) && !(controlledSquares & m_CastlingPath[playerColour | QueenSide]))
-            legalMoves |= 0x04ull << (playerColour == White ? 0 : 56);
+    const BitBoard targets = ~ourPieces & masks.CheckMask;
 
-        return legalMoves & ~controlledSquares;
+    // Pawns reaching the last rank have four moves (one for each promotion)
+    auto countPawnMoves = [](BitBoard destinations) {
+        return SquareCount(destinations & ~LastRank) + 4 * SquareCount(destinations & LastRank);
+    };
+
+    const PawnTargets pawnTargets = GetPawnTargets<Us>(masks);
+    count += countPawnMoves(pawnTargets.SinglePushes) + SquareCount(pawnTargets.DoublePushes)
+        + countPawnMoves(pawnTargets.WestCaptures) + countPawnMoves(pawnTargets.EastCaptures);
+
+    if (m_EnPassantSquare != 0) {
+        for (Square source : Squares(PseudoLegal::PawnAttack<Them>(m_EnPassantSquare) & ourPieces & m_PieceBitBoards[Pawn]))
+            count += IsEnPassantLegal<Us>(source, masks);
     }
 
-    Square kingSquare = GetSquare(king);
+    const BitBoard pinned = masks.RookPin | masks.BishopPin;
+
+    for (Square source : Squares(ourPieces & m_PieceBitBoards[Knight] & ~pinned))
+        count += SquareCount(PseudoLegal::KnightAttack(source) & targets);
+
+    for (Square source : Squares(ourPieces & (m_PieceBitBoards[Bishop] | m_PieceBitBoards[Queen]) & ~masks.RookPin)) {
+        BitBoard legalMoves = PseudoLegal::BishopAttack(source, allPieces) & targets;
+        if ((1ull << source) & masks.BishopPin)
+            legalMoves &= PseudoLegal::LineThrough(kingSquare, source);
+        count += SquareCount(legalMoves);
+    }
+
+    for (Square source : Squares(ourPieces & (m_PieceBitBoards[Rook] | m_PieceBitBoards[Queen]) & ~masks.BishopPin)) {
+        BitBoard legalMoves = PseudoLegal::RookAttack(source, allPieces) & targets;
+        if ((1ull << source) & masks.RookPin)
+            legalMoves &= PseudoLegal::LineThrough(kingSquare, source);
+        count += SquareCount(legalMoves);
+    }
+
+    return count;
+}
+
+template <Colour Us>
+Board::PawnTargets Board::GetPawnTargets(const MoveMasks& masks) const {
+    constexpr Colour Them = OppositeColour(Us);
+    constexpr BitBoard ThirdRank = Us == White ? 0x0000000000FF0000 : 0x0000FF0000000000;  // Where a pawn pushed from the start lands
+
+    // A pawn pinned on a file can only push, and one pinned on a diagonal can only capture along it.
+    // Moving along its own pin keeps a pawn in the pin mask, and no other move can land in it.
+    const BitBoard allPieces = m_ColourBitBoards[White] | m_ColourBitBoards[Black];
+    const BitBoard pawns = m_ColourBitBoards[Us] & m_PieceBitBoards[Pawn];
+
+    PawnTargets targets;
+
+    const BitBoard pushers = pawns & ~masks.BishopPin;
+    const BitBoard singlePushes = (PseudoLegal::PawnPushes<Us>(pushers & ~masks.RookPin)
+        | (PseudoLegal::PawnPushes<Us>(pushers & masks.RookPin) & masks.RookPin)) & ~allPieces;
+
+    targets.SinglePushes = singlePushes & masks.CheckMask;
+    targets.DoublePushes = PseudoLegal::PawnPushes<Us>(singlePushes & ThirdRank) & ~allPieces & masks.CheckMask;
+
+    const BitBoard captureTargets = m_ColourBitBoards[Them] & masks.CheckMask;
+    const BitBoard capturers = pawns & ~masks.RookPin;
+    const BitBoard pinnedCapturers = capturers & masks.BishopPin;
+
+    targets.WestCaptures = (PseudoLegal::PawnWestAttacks<Us>(capturers & ~pinnedCapturers)
+        | (PseudoLegal::PawnWestAttacks<Us>(pinnedCapturers) & masks.BishopPin)) & captureTargets;
+    targets.EastCaptures = (PseudoLegal::PawnEastAttacks<Us>(capturers & ~pinnedCapturers)
+        | (PseudoLegal::PawnEastAttacks<Us>(pinnedCapturers) & masks.BishopPin)) & captureTargets;
+
+    return targets;
+}
 
-    BitBoard checkMask = 0;
-    BitBoard checkers = 0;
+template <Colour Us>
+Board::MoveMasks Board::CalculateMoveMasks() const {
+    constexpr Colour Them = OppositeColour(Us);
+
+    const BitBoard allPieces = m_ColourBitBoards[White] | m_ColourBitBoards[Black];
+    const BitBoard king = m_ColourBitBoards[Us] & m_PieceBitBoards[King];
+    const BitBoard enemyPieces = m_ColourBitBoards[Them];
+    const Square kingSquare = GetSquare(king);
+
+    const BitBoard ourPieces = m_ColourBitBoards[Us];
+    const BitBoard diagonalSliders = enemyPieces & (m_PieceBitBoards[Bishop] | m_PieceBitBoards[Queen]);
+    const BitBoard straightSliders = enemyPieces & (m_PieceBitBoards[Rook] | m_PieceBitBoards[Queen]);
+
+    MoveMasks masks;
 
     // Deals with checks from bishops, queens
-    BitBoard bishopView = PseudoLegal::BishopAttack(kingSquare, allPieces);
-    BitBoard bishopCheck = bishopView & enemyPieces & (m_PieceBitBoards[Bishop] | m_PieceBitBoards[Queen]);
-    checkers |= bishopCheck;
-    checkMask |= PseudoLegal::Line(king, bishopCheck);
+    const BitBoard bishopView = PseudoLegal::BishopAttack(kingSquare, allPieces);
+    const BitBoard bishopCheck = bishopView & diagonalSliders;
+    masks.Checkers |= bishopCheck;
+    for (Square checker : Squares(bishopCheck))
+        masks.CheckMask |= PseudoLegal::Between(kingSquare, checker) | (1ull << checker);
 
     // Deals with pins from bishops, queens
-    BitBoard bishopXRay = PseudoLegal::BishopAttack(kingSquare, allPieces & ~bishopView) & enemyPieces & (m_PieceBitBoards[Bishop] | m_PieceBitBoards[Queen]);
-    BitBoard bishopPin = 0;
-    while (bishopXRay) {
-        bishopPin |= PseudoLegal::Line(king, bishopXRay);
-        bishopXRay &= bishopXRay - 1;
-    }
+    // Looking through our pieces next to the king finds the sliders pinning them
+    const BitBoard bishopXRay = PseudoLegal::BishopAttack(kingSquare, allPieces & ~(bishopView & ourPieces)) & diagonalSliders & ~bishopView;
+    for (Square pinner : Squares(bishopXRay))
+        masks.BishopPin |= PseudoLegal::Between(kingSquare, pinner) | (1ull << pinner);
 
     // Deals with checks from rooks, queens
-    BitBoard rookView = PseudoLegal::RookAttack(kingSquare, allPieces);
-    BitBoard rookCheck = rookView & enemyPieces & (m_PieceBitBoards[Rook] | m_PieceBitBoards[Queen]);
-    checkers |= rookCheck;
-    checkMask |= PseudoLegal::Line(king, rookCheck);
+    const BitBoard rookView = PseudoLegal::RookAttack(kingSquare, allPieces);
+    const BitBoard rookCheck = rookView & straightSliders;
+    masks.Checkers |= rookCheck;
+    for (Square checker : Squares(rookCheck))
+        masks.CheckMask |= PseudoLegal::Between(kingSquare, checker) | (1ull << checker);
 
     // Deals with pins from rooks and queens
-    BitBoard rookXRay = PseudoLegal::RookAttack(kingSquare, allPieces & ~rookView) & enemyPieces & (m_PieceBitBoards[Rook] | m_PieceBitBoards[Queen]);
-    BitBoard rookPin = 0;
-    while (rookXRay) {
-        rookPin |= PseudoLegal::Line(king, rookXRay);
-        rookXRay &= rookXRay - 1;
-    }
+    const BitBoard rookXRay = PseudoLegal::RookAttack(kingSquare, allPieces & ~(rookView & ourPieces)) & straightSliders & ~rookView;
+    for (Square pinner : Squares(rookXRay))
+        masks.RookPin |= PseudoLegal::Between(kingSquare, pinner) | (1ull << pinner);
 
     // Deals with checks from knights
     BitBoard knightCheck = PseudoLegal::KnightAttack(kingSquare) & enemyPieces & m_PieceBitBoards[Knight];
-    checkers |= knightCheck;
-    checkMask |= knightCheck;
+    masks.Checkers |= knightCheck;
+    masks.CheckMask |= knightCheck;
 
     // Deals with checks from pawns
-    BitBoard pawnCheck = PseudoLegal::PawnAttack(kingSquare, playerColour) & enemyPieces & m_PieceBitBoards[Pawn];
-    checkers |= pawnCheck;
-    checkMask |= pawnCheck;
+    BitBoard pawnCheck = PseudoLegal::PawnAttack<Us>(kingSquare) & enemyPieces & m_PieceBitBoards[Pawn];
+    masks.Checkers |= pawnCheck;
+    masks.CheckMask |= pawnCheck;
 
     // If there are no checks, we don't prune any moves
-    if (checkMask == 0)
-        checkMask = 0xFFFFFFFFFFFFFFFF;
-    
+    if (masks.CheckMask == 0)
+        masks.CheckMask = 0xFFFFFFFFFFFFFFFF;
+
     // If it is double check, we can remove all blocking moves (we can only move the king)
-    checkMask *= SquareCount(checkers) < 2;
+    masks.CheckMask *= SquareCount(masks.Checkers) < 2;
+
+    return masks;
+}
+
+template <Colour Us>
+BitBoard Board::GetKingLegalMoves(Square king, BitBoard controlledSquares) const {
+    constexpr BitBoard KingSideDestination = Us == White ? 1ull << G1 : 1ull << G8;
+    constexpr BitBoard QueenSideDestination = Us == White ? 1ull << C1 : 1ull << C8;
+    constexpr BitBoard QueenSideRookPath = Us == White ? 1ull << B1 : 1ull << B8;
 
+    const BitBoard kingSquare = 1ull << king;
+    const BitBoard otherPieces = (m_ColourBitBoards[White] | m_ColourBitBoards[Black]) & ~kingSquare;
+
+    BitBoard legalMoves = PseudoLegal::KingAttack(king) & ~m_ColourBitBoards[Us];
+
+    // Deals with castling
+    // The path must be empty, and the king can't castle out of, through or into check
+    // (the rook may pass through an attacked square, which is why b1/b8 is ignored)
+    const BitBoard kingSide = m_CastlingPath[Us | KingSide];
+    const BitBoard queenSide = m_CastlingPath[Us | QueenSide];
+    if (!(otherPieces & kingSide) && !(controlledSquares & (kingSide | kingSquare)))
+        legalMoves |= KingSideDestination;
+    if (!(otherPieces & queenSide) && !(controlledSquares & (queenSide | kingSquare) & ~QueenSideRookPath))
+        legalMoves |= QueenSideDestination;
+
+    return legalMoves & ~controlledSquares;
+}
+
+template <Colour Us>
+BitBoard Board::GetPieceLegalMoves(Square piece, const MoveMasks& masks) const {
     BitBoard pseudoLegal = GetPseudoLegalMoves(piece);
 
-    BitBoard pieceSquare = 1ull << piece;
-    if (pieceSquare & rookPin)  // If piece is horizontally pinned
-        pseudoLegal &= rookPin & PseudoLegal::RookAttack(piece, allPieces);
-    else if (pieceSquare & bishopPin)  // If piece is diagonally pinned
-        pseudoLegal &= bishopPin & PseudoLegal::BishopAttack(piece, allPieces);
+    // En passant is dealt with separately below
+    const BitBoard enPassant = (GetPieceType(m_Board[piece]) == Pawn && m_EnPassantSquare != 0) ? pseudoLegal & (1ull << m_EnPassantSquare) : 0;
+    pseudoLegal &= ~enPassant;
 
-    pseudoLegal &= checkMask;
+    // A pinned piece can only move along the line through the king and itself
+    if ((1ull << piece) & (masks.RookPin | masks.BishopPin))
+        pseudoLegal &= PseudoLegal::LineThrough(GetSquare(m_ColourBitBoards[Us] & m_PieceBitBoards[King]), piece);
 
-    // Handles en passant pin: 8/4p3/8/2K2P1r/8/8/8/7k b - - 0 1
-    if (GetPieceType(m_Board[piece]) == Pawn && king & 0x000000FFFF000000 && m_EnPassantSquare) {
-        // Gets the two pawns involved in en passant
-        BitBoard twoPawns = ((1ull << (m_EnPassantSquare + 8)) | (1ull << (m_EnPassantSquare - 8))) & 0x000000FFFF000000;
-        twoPawns |= pieceSquare;
+    pseudoLegal &= masks.CheckMask;
 
-        // Removes the pawns and sees if king is in check
-        rookView = PseudoLegal::RookAttack(kingSquare, allPieces & ~twoPawns);
-        if (rookView & enemyPieces & (m_PieceBitBoards[Rook] | m_PieceBitBoards[Queen]))
-            pseudoLegal &= ~(1ull << m_EnPassantSquare);
-    }
+    if (enPassant && IsEnPassantLegal<Us>(piece, masks))
+        pseudoLegal |= enPassant;
 
     return pseudoLegal;
 }
 
+template <Colour Us>
+bool Board::IsEnPassantLegal(Square source, const MoveMasks& masks) const {
+    constexpr Colour Them = OppositeColour(Us);
+
+    const BitBoard allPieces = m_ColourBitBoards[White] | m_ColourBitBoards[Black];
+    const BitBoard enPassant = 1ull << m_EnPassantSquare;
+
+    // Handles en passant pins: 8/4p3/8/2K2P1r/8/8/8/7k b - - 0 1
+    // Removes both pawns from the board and sees if the king is attacked by a slider
+    // The capture must also deal with any check, either by taking the checking pawn or by blocking
+    const BitBoard captured = 1ull << (m_EnPassantSquare - PseudoLegal::PawnPushOffset<Us>);
+    const BitBoard occupied = (allPieces & ~((1ull << source) | captured)) | enPassant;
+    const Square kingSquare = GetSquare(m_ColourBitBoards[Us] & m_PieceBitBoards[King]);
+
+    const BitBoard discovered = (PseudoLegal::RookAttack(kingSquare, occupied) & (m_PieceBitBoards[Rook] | m_PieceBitBoards[Queen]))
+        | (PseudoLegal::BishopAttack(kingSquare, occupied) & (m_PieceBitBoards[Bishop] | m_PieceBitBoards[Queen]));
+
+    return !(discovered & m_ColourBitBoards[Them]) && ((enPassant | captured) & masks.CheckMask);
+}
+
 BitBoard Board::GetPseudoLegalMoves(Square piece) const {
     PieceType pt = GetPieceType(m_Board[piece]);
     Colour c = GetColour(m_Board[piece]);
@@ -535,25 +1153,120 @@ BitBoard Board::GetPseudoLegalMoves(Square piece) const {
     }
 }
 
-BitBoard Board::ControlledSquares(Colour c) const {
-    BitBoard king = m_ColourBitBoards[OppositeColour(c)] & m_PieceBitBoards[King];
-    BitBoard blockers = (m_ColourBitBoards[White] | m_ColourBitBoards[Black]) ^ king;
+CHESS_MULTIVERSION BitBoard Board::CalculateControlledSquares(Colour c) const {
+    const BitBoard pieces = m_ColourBitBoards[c];
+    const BitBoard king = m_ColourBitBoards[OppositeColour(c)] & m_PieceBitBoards[King];
+    const BitBoard blockers = (m_ColourBitBoards[White] | m_ColourBitBoards[Black]) ^ king;
 
-    BitBoard controlledSquares = 0;
-    for (Square s = 0; s < 64; s++) {
-        if (m_Board[s] != Piece::None && GetColour(m_Board[s]) == c) {
-            switch (GetPieceType(m_Board[s])) {
-                case Pawn:   controlledSquares |= PseudoLegal::PawnAttack(s, c); break;
-                case Knight: controlledSquares |= PseudoLegal::KnightAttack(s); break;
-                case Bishop: controlledSquares |= PseudoLegal::BishopAttack(s, blockers); break;
-                case Rook:   controlledSquares |= PseudoLegal::RookAttack(s, blockers); break;
-                case Queen:  controlledSquares |= PseudoLegal::QueenAttack(s, blockers); break;
-                case King:   controlledSquares |= PseudoLegal::KingAttack(s); break;
+    BitBoard controlledSquares = PseudoLegal::PawnAttacks(pieces & m_PieceBitBoards[Pawn], c)
+        | PseudoLegal::SliderAttacks(pieces & (m_PieceBitBoards[Bishop] | m_PieceBitBoards[Queen]),
+                                     pieces & (m_PieceBitBoards[Rook] | m_PieceBitBoards[Queen]), blockers)
+        | PseudoLegal::KingAttack(GetSquare(pieces & m_PieceBitBoards[King]));
 
-                default: return 0;
-            }
+    for (Square s : Squares(pieces & m_PieceBitBoards[Knight]))
+        controlledSquares |= PseudoLegal::KnightAttack(s);
+
+    return controlledSquares;
+}
+
+BitBoard Board::AttackersTo(Square square, BitBoard occupied) const {
+    // A piece on 'square' attacks the same squares that attack 'square'
+    // (pawns are the exception: a white pawn attacks a square from where a black pawn would attack it)
+    const BitBoard pawns = (PseudoLegal::PawnAttack(square, Black) & m_ColourBitBoards[White])
+        | (PseudoLegal::PawnAttack(square, White) & m_ColourBitBoards[Black]);
+
+    return (pawns & m_PieceBitBoards[Pawn])
+        | (PseudoLegal::KnightAttack(square) & m_PieceBitBoards[Knight])
+        | (PseudoLegal::BishopAttack(square, occupied) & (m_PieceBitBoards[Bishop] | m_PieceBitBoards[Queen]))
+        | (PseudoLegal::RookAttack(square, occupied) & (m_PieceBitBoards[Rook] | m_PieceBitBoards[Queen]))
+        | (PseudoLegal::KingAttack(square) & m_PieceBitBoards[King]);
+}
+
+int32_t Board::SEE(PackedMove m) const {
+    const Square source = m.SourceSquare();
+    const Square destination = m.DestinationSquare();
+    const Colour colour = GetColour(m_Board[source]);
+
+    const BitBoard diagonalSliders = m_PieceBitBoards[Bishop] | m_PieceBitBoards[Queen];
+    const BitBoard straightSliders = m_PieceBitBoards[Rook] | m_PieceBitBoards[Queen];
+
+    BitBoard occupied = (m_ColourBitBoards[White] | m_ColourBitBoards[Black]) & ~(1ull << source);
+    PieceType onDestination = GetPieceType(m_Board[source]);  // The piece the next capture takes
+
+    // The swap list: gains[i] is what the player making the i-th capture has won if the exchange stops after it
+    std::array<int32_t, 32> gains;
+    gains[0] = m_Board[destination] != Piece::None ? SEEValues[GetPieceType(m_Board[destination])] : 0;
+
+    if (onDestination == Pawn) {
+        if (m_EnPassantSquare != 0 && destination == m_EnPassantSquare) {
+            gains[0] = SEEValues[Pawn];
+            occupied &= ~(1ull << (colour == White ? destination - 8 : destination + 8));
+        } else if (m.Promotion() != Pawn && ((1ull << destination) & 0xFF000000000000FF)) {
+            gains[0] += SEEValues[m.Promotion()] - SEEValues[Pawn];
+            onDestination = m.Promotion();
         }
     }
 
-    return controlledSquares;
+    // Removing a piece from 'occupied' uncovers the sliders behind it
+    BitBoard attackers = AttackersTo(destination, occupied) & occupied;
+    Colour side = colour;
+    size_t depth = 0;
+
+    for (;;) {
+        side = OppositeColour(side);
+
+        const BitBoard sideAttackers = attackers & m_ColourBitBoards[side];
+        if (!sideAttackers)
+            break;
+
+        PieceType attacker = Pawn;
+        while (!(sideAttackers & m_PieceBitBoards[attacker]))
+            attacker = (PieceType)(attacker + 1);
+
+        // The king can't take if the square is still defended
+        if (attacker == King && (attackers & m_ColourBitBoards[OppositeColour(side)]))
+            break;
+
+        depth++;
+        gains[depth] = SEEValues[onDestination] - gains[depth - 1];
+        onDestination = attacker;
+
+        occupied &= ~(1ull << GetSquare(sideAttackers & m_PieceBitBoards[attacker]));
+
+        if (attacker == Pawn || attacker == Bishop || attacker == Queen)
+            attackers |= PseudoLegal::BishopAttack(destination, occupied) & diagonalSliders;
+        if (attacker == Rook || attacker == Queen)
+            attackers |= PseudoLegal::RookAttack(destination, occupied) & straightSliders;
+        attackers &= occupied;
+    }
+
+    // Each player only captures if it gains more than stopping the exchange
+    for (; depth > 0; depth--)
+        gains[depth - 1] = -std::max(-gains[depth - 1], gains[depth]);
+
+    return gains[0];
+}
+
+bool Board::SEEGreaterOrEqual(PackedMove m, int32_t threshold) const {
+    const Piece victim = m_Board[m.DestinationSquare()];
+    const PieceType attacker = GetPieceType(m_Board[m.SourceSquare()]);
+
+    // Promotions and en passant are left to the full exchange
+    if (m.Promotion() == Pawn && !(attacker == Pawn && m_EnPassantSquare != 0 && m.DestinationSquare() == m_EnPassantSquare)) {
+        // Not enough even if the victim is won for free
+        const int32_t best = (victim != Piece::None ? SEEValues[GetPieceType(victim)] : 0) - threshold;
+        if (best < 0)
+            return false;
+
+        // Enough even if the attacker is lost straight away (a king can't be lost)
+        if (attacker == King || best - SEEValues[attacker] >= 0)
+            return true;
+    }
+
+    return SEE(m) >= threshold;
+}
+
+bool Board::IsInCheck(Colour colour) const {
+    const BitBoard king = m_ColourBitBoards[colour] & m_PieceBitBoards[King];
+    return AttackersTo(GetSquare(king)) & m_ColourBitBoards[OppositeColour(colour)];
 }
@@ -3,10 +3,32 @@
 #include <array>
 #include <ostream>
 #include <string>
+#include <vector>
 
 #include "BitBoard.h"
 #include "BoardFormat.h"
+#include "Evaluation.h"
 #include "Move.h"
+#include "MoveList.h"
+#include "Zobrist.h"
+
+// The information needed to undo a move that can't be calculated from the move itself
+struct UndoInfo {
+    Piece Captured = Piece::None;
+    Square EnPassantSquare = 0;
+    uint8_t CastlingRights = 0;  // Bit 'i' is set if m_CastlingPath[i] allows castling
+    int32_t HalfMoves = 0;
+};
+
+// The state of the game for the player whose turn it is
+enum class GameStatus : uint8_t {
+    Ongoing,
+    Checkmate,
+    Stalemate,
+    FiftyMove,             // 100 half moves without a pawn move or capture
+    InsufficientMaterial,  // Neither side can possibly mate
+    Repetition,            // The same position for the third time
+};
 
 class Board {
 public:
@@ -23,23 +45,176 @@ public:
     inline Piece operator[](Square s) const { return m_Board[s]; }
 
     inline Colour GetPlayerTurn() const { return m_PlayerTurn; }
+    inline int32_t GetHalfMoves() const { return m_HalfMoves; }  // Since the last pawn move or capture
+    inline int32_t GetFullMoves() const { return m_FullMoves; }  // Starts at 1, and goes up after Black moves
+
+    // A 64-bit key of the position (pieces, player turn, castling rights and en passant square)
+    // It is updated after every move, so it costs nothing to get
+    inline uint64_t Hash() const { return m_Hash; }
+
+    // A 64-bit key of the pawns only (for caching pawn structure analysis), also updated after every move
+    inline uint64_t PawnHash() const { return m_PawnHash; }
+
+    // The pieces of one type and colour
+    inline BitBoard Pieces(PieceType type, Colour colour) const { return m_PieceBitBoards[type] & m_ColourBitBoards[colour]; }
 
+    // The material and piece placement score (Evaluation.h) in centipawns for the player whose turn it is
+    // The middlegame and endgame totals are blended by the game phase, from all the pieces (middlegame) to none (endgame)
+    // The totals are updated as pieces are placed and removed, so it costs next to nothing
+    inline int32_t StaticEval() const;
+
+    // The value of the pieces of 'colour' (SEEValues, the king not counted), also kept up to date on every move
+    inline int32_t Material(Colour colour) const { return m_Material[colour]; }
+
+    // Plays a move and returns it in the other notation
+    // Throws IllegalMoveException if the move isn't legal
     AlgebraicMove Move(LongAlgebraicMove m);
     LongAlgebraicMove Move(AlgebraicMove m);
 
-    inline bool IsMoveLegal(LongAlgebraicMove m) { return GetPieceLegalMoves(m.SourceSquare) & (1ull << m.DestinationSquare); }
+    // Plays a move without working out its algebraic notation (for replaying games and continuations)
+    // Throws IllegalMoveException if the move isn't legal
+    // Call ToAlgebraic() before playing the move if the notation is needed after all
+    void Apply(PackedMove m);
+
+    // Plays a legal move (from GenerateLegalMoves()) without any checks or notation
+    // 'undo' is filled with what is needed to take the move back with UnmakeMove()
+    void MakeMove(PackedMove m, UndoInfo& undo);
+    void UnmakeMove(PackedMove m, const UndoInfo& undo);
+
+    // Converts a move of this position to and from standard algebraic notation
+    // ToAlgebraic() fills in the disambiguation, check and checkmate flags
+    // FromAlgebraic() throws if the move doesn't match exactly one legal move
+    AlgebraicMove ToAlgebraic(PackedMove m) const;
+    PackedMove FromAlgebraic(const AlgebraicMove& m) const;
+
+    inline bool IsMoveLegal(LongAlgebraicMove m) const { return GetPieceLegalMoves(m.SourceSquare) & (1ull << m.DestinationSquare); }
+
+    bool HasLegalMoves(Colour colour) const;
+
+    // Checks the cheap draws first, and only looks for a legal move until it finds one
+    GameStatus Status() const;
+    bool IsInsufficientMaterial() const;  // Only kings and minor pieces, and no mate is possible
 
-    bool HasLegalMoves(Colour colour);
-    BitBoard GetPieceLegalMoves(Square piece);
+    // If this position has been reached 'count' times (including now) since the last pawn move or capture
+    // Only looks at every other position in that range, so it's cheap enough to call in a search (with a count of 2)
+    bool IsRepetition(int32_t count = 3) const;
+    BitBoard GetPieceLegalMoves(Square piece) const;
+
+    // Adds every legal move of the player whose turn it is to 'moves'
+    void GenerateLegalMoves(MoveList& moves) const;
+
+    // The legal moves in stages, which add up to GenerateLegalMoves() (in a different order)
+    // Captures: captures, en passant and every promotion, most valuable victim first (then least valuable attacker)
+    // Quiet moves: the rest (including castling)
+    // Evasions: every legal move if the player is in check (they all get out of check), and nothing if not
+    void GenerateCaptures(MoveList& moves) const;
+    void GenerateQuietMoves(MoveList& moves) const;
+    void GenerateEvasions(MoveList& moves) const;
+
+    // The number of legal moves, counted with popcounts without making a move list
+    size_t CountLegalMoves() const;
+
+    // Adds the pseudo-legal moves of the player whose turn it is: moves that follow the rules of each piece
+    // but may leave the king in check (castling only needs an empty path and the rights)
+    // No pins or checks are worked out, so it's cheaper than GenerateLegalMoves() when only a few moves get tried,
+    // but every move must pass IsLegal() before it's played
+    void GeneratePseudoLegalMoves(MoveList& moves) const;
+
+    // The pieces of the player whose turn it is that are pinned to their king, and the enemy pieces giving check
+    // Worked out once per position for IsLegal()
+    BitBoard PinnedPieces() const;
+    BitBoard Checkers() const;
+
+    // If a move from GeneratePseudoLegalMoves() doesn't leave the king in check
+    // When not in check, only king moves, en passant and moves of pinned pieces need any work
+    bool IsLegal(PackedMove m, BitBoard pinned, BitBoard checkers) const;
+
+    // Returns the pieces of both colours that attack 'square' if the occupied squares were 'occupied'
+    BitBoard AttackersTo(Square square, BitBoard occupied) const;
+    inline BitBoard AttackersTo(Square square) const { return AttackersTo(square, m_ColourBitBoards[White] | m_ColourBitBoards[Black]); }
+
+    // Every square attacked by 'colour' (sliders see through the enemy king, so it can't step back along their line)
+    // The sliders are done all at once (PseudoLegal::SliderAttacks()), and the result is kept until the pieces change
+    BitBoard AttackedBy(Colour colour) const;
+
+    // If the king of 'colour' is attacked
+    bool IsInCheck(Colour colour) const;
+
+    // Static exchange evaluation: the material won (in centipawns) by the player making 'm' after both sides
+    // keep capturing on the destination with their least valuable attacker (and stop when it stops paying)
+    // Sliders behind other attackers (x-rays) join in, pins are ignored
+    int32_t SEE(PackedMove m) const;
+    // If SEE(m) >= threshold, usually without playing out the whole exchange
+    bool SEEGreaterOrEqual(PackedMove m, int32_t threshold) const;
+
+    // The piece values used by SEE(), indexed by PieceType (the king is never captured)
+    static constexpr std::array<int32_t, PieceTypeCount> SEEValues = { 100, 300, 300, 500, 900, 0 };
 
     static constexpr std::string_view StartFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1\0";
 private:
+    // Check and pin information for one side
+    // Calculated once per position and shared by all of that side's pieces
+    struct MoveMasks {
+        BitBoard Checkers = 0;   // The enemy pieces giving check
+        BitBoard CheckMask = 0;  // The squares that capture or block the check (all squares if not in check)
+        BitBoard RookPin = 0;    // Horizontal and vertical pin rays (the squares after the king, up to and including the pinning piece)
+        BitBoard BishopPin = 0;  // Diagonal pin rays (the squares after the king, up to and including the pinning piece)
+    };
+
+    // Throws if 'm' isn't a move of the player whose turn it is, or is a pawn reaching the last rank without a promotion,
+    // or has a promotion but isn't a pawn reaching the last rank
+    // Only castling is fully checked, other moves may still leave the king in check
+    void ValidateMove(PackedMove m) const;
+    // Plays a move that passed ValidateMove(), and takes it back and throws if it leaves the king in check
+    // There is no UndoInfo to take it back later, so the history before a pawn move or capture is dropped
+    void MakeValidatedMove(PackedMove m);
+
+    // The algebraic notation of a move, without the check and checkmate flags (they need the position after the move)
+    AlgebraicMove AnnotateMove(PackedMove m) const;
+
+    // The move generation is specialised for each colour (Us), and the public functions
+    // pick the specialisation once per call, so the inner loops have no colour branches
+    template <Colour Us> MoveMasks CalculateMoveMasks() const;
+    inline MoveMasks CalculateMoveMasks(Colour colour) const { return colour == White ? CalculateMoveMasks<White>() : CalculateMoveMasks<Black>(); }
+
+    enum MoveType : uint8_t { AllMoves, CaptureMoves, QuietMoves, Evasions };
+    template <Colour Us, MoveType Type> void GenerateMoves(MoveList& moves) const;
+    template <Colour Us> bool HasLegalMoves() const;
+    template <Colour Us> size_t CountLegalMoves() const;
+
+    template <Colour Us> BitBoard GetKingLegalMoves(Square king, BitBoard controlledSquares) const;
+    template <Colour Us> BitBoard GetPieceLegalMoves(Square piece, const MoveMasks& masks) const;  // Not for kings
+    inline BitBoard GetPieceLegalMoves(Square piece, const MoveMasks& masks, Colour colour) const {
+        return colour == White ? GetPieceLegalMoves<White>(piece, masks) : GetPieceLegalMoves<Black>(piece, masks);
+    }
+
+    // The destinations of the pawn moves of Us (pins and checks applied, en passant not included)
+    struct PawnTargets {
+        BitBoard SinglePushes = 0;
+        BitBoard DoublePushes = 0;
+        BitBoard WestCaptures = 0;  // Towards the a-file
+        BitBoard EastCaptures = 0;  // Towards the h-file
+    };
+
+    template <Colour Us> PawnTargets GetPawnTargets(const MoveMasks& masks) const;
+
+    // If the pawn on 'source' can take en passant (the en passant square must be set)
+    template <Colour Us> bool IsEnPassantLegal(Square source, const MoveMasks& masks) const;
+
     BitBoard GetPseudoLegalMoves(Square piece) const;
 
     void PlacePiece(Piece p, Square s);
     void RemovePiece(Square s);
 
-    BitBoard ControlledSquares(Colour colour) const;
+    BitBoard CalculateControlledSquares(Colour colour) const;  // For AttackedBy()
+
+    uint8_t GetCastlingRights() const;  // Bit 'i' is set if m_CastlingPath[i] allows castling
+    void SetEnPassantSquare(Square s);
+    void SwitchPlayerTurn();
+
+    uint64_t CalculateHash() const;  // Calculates the hash from scratch
+    uint64_t CalculatePawnHash() const;
+    void CalculateEvaluation();      // Calculates the material, piece-square totals and phase from scratch
 private:
     std::array<BitBoard, ColourCount> m_ColourBitBoards;
     std::array<BitBoard, PieceTypeCount> m_PieceBitBoards;
@@ -66,15 +241,43 @@ private:
     Square m_EnPassantSquare;
     
     Colour m_PlayerTurn;
+
+    uint64_t m_Hash = 0;
+    uint64_t m_PawnHash = 0;
+
+    // Running totals for StaticEval() and Material(), updated by PlacePiece() and RemovePiece()
+    std::array<int32_t, ColourCount> m_Material = {};
+    std::array<int32_t, ColourCount> m_MidGameScore = {};  // Material included
+    std::array<int32_t, ColourCount> m_EndGameScore = {};
+    int32_t m_Phase = 0;  // Up to Evaluation::MaxPhase (more if there are promoted pieces)
+
+    // Cache for AttackedBy(), bit 'colour' of the flags is set if the squares are up to date
+    // (a const Board shouldn't be shared between threads because of this)
+    mutable std::array<BitBoard, ColourCount> m_ControlledSquares = {};
+    mutable uint8_t m_ControlledSquaresValid = 0;
     
     int32_t m_HalfMoves = 0;  // Number of half moves since the last pawn move or capture
     int32_t m_FullMoves = 1;  // The number of the full moves; it starts at 1, and is incremented after Black's move
+
+    // The hashes of the positions before each move, for finding repetitions
+    // Only the positions after the last pawn move or capture (counted by the half move clock) can repeat,
+    // so moves that can't be taken back (Apply() and Move()) drop the ones before, which keeps it short
+    // It's on the heap so copying a board stays cheap
+    std::vector<uint64_t> m_HashHistory;
 };
 
 inline void Board::PlacePiece(Piece p, Square s) {
     m_PieceBitBoards[GetPieceType(p)] |= 1ull << s;
     m_ColourBitBoards[GetColour(p)] |= 1ull << s;
     m_Board[s] = p;
+    m_Hash ^= Zobrist::PieceKey(p, s);
+    m_PawnHash ^= Zobrist::PawnKey(p, s);
+    m_ControlledSquaresValid = 0;
+
+    m_Material[GetColour(p)] += SEEValues[GetPieceType(p)];
+    m_MidGameScore[GetColour(p)] += Evaluation::MidGame(p, s);
+    m_EndGameScore[GetColour(p)] += Evaluation::EndGame(p, s);
+    m_Phase += Evaluation::PhaseWeight(p);
 }
 
 inline void Board::RemovePiece(Square s) {
@@ -83,9 +286,45 @@ inline void Board::RemovePiece(Square s) {
         m_PieceBitBoards[GetPieceType(p)] &= ~(1ull << s);
         m_ColourBitBoards[GetColour(p)] &= ~(1ull << s);
         m_Board[s] = Piece::None;
+        m_Hash ^= Zobrist::PieceKey(p, s);
+        m_PawnHash ^= Zobrist::PawnKey(p, s);
+        m_ControlledSquaresValid = 0;
+
+        m_Material[GetColour(p)] -= SEEValues[GetPieceType(p)];
+        m_MidGameScore[GetColour(p)] -= Evaluation::MidGame(p, s);
+        m_EndGameScore[GetColour(p)] -= Evaluation::EndGame(p, s);
+        m_Phase -= Evaluation::PhaseWeight(p);
     }
 }
 
+inline int32_t Board::StaticEval() const {
+    const int32_t phase = m_Phase < Evaluation::MaxPhase ? m_Phase : Evaluation::MaxPhase;
+    const int32_t midGame = m_MidGameScore[White] - m_MidGameScore[Black];
+    const int32_t endGame = m_EndGameScore[White] - m_EndGameScore[Black];
+
+    const int32_t score = (midGame * phase + endGame * (Evaluation::MaxPhase - phase)) / Evaluation::MaxPhase;
+    return m_PlayerTurn == White ? score : -score;
+}
+
+inline BitBoard Board::AttackedBy(Colour colour) const {
+    if (!(m_ControlledSquaresValid & (1 << colour))) {
+        m_ControlledSquares[colour] = CalculateControlledSquares(colour);
+        m_ControlledSquaresValid |= 1 << colour;
+    }
+
+    return m_ControlledSquares[colour];
+}
+
+inline void Board::SetEnPassantSquare(Square s) {
+    m_Hash ^= Zobrist::EnPassantKey(m_EnPassantSquare) ^ Zobrist::EnPassantKey(s);
+    m_EnPassantSquare = s;
+}
+
+inline void Board::SwitchPlayerTurn() {
+    m_PlayerTurn = OppositeColour(m_PlayerTurn);
+    m_Hash ^= Zobrist::PlayerTurnKey();
+}
+
 inline std::ostream& operator<<(std::ostream& os, const Board& board) {
     static std::array<std::string_view, ColourCount> rankNumbers = { "12345678", "87654321" };
 
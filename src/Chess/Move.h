@@ -144,6 +144,40 @@ inline std::ostream& operator<<(std::ostream& os, LongAlgebraicMove m) {
     return os;
 }
 
+// A move packed into 16 bits, for move lists and anything that stores a lot of moves
+// Bits 0-5: source square, bits 6-11: destination square, bits 12-15: promotion (Pawn if none)
+// Castling and en passant are not flagged, they are recognised from the position
+class PackedMove {
+public:
+    PackedMove() = default;  // Uninitialised, so arrays of moves are free to create
+
+    constexpr PackedMove(Square source, Square destination, PieceType promotion = Pawn)
+        : m_Data(static_cast<uint16_t>(source | (destination << 6) | (promotion << 12))) {}
+
+    constexpr PackedMove(LongAlgebraicMove m)
+        : PackedMove(m.SourceSquare, m.DestinationSquare, m.Promotion) {}
+
+    constexpr Square SourceSquare() const { return m_Data & 0x3F; }
+    constexpr Square DestinationSquare() const { return (m_Data >> 6) & 0x3F; }
+    constexpr PieceType Promotion() const { return static_cast<PieceType>(m_Data >> 12); }
+
+    inline LongAlgebraicMove ToLongAlgebraic() const { return { SourceSquare(), DestinationSquare(), Promotion() }; }
+    inline std::string ToString() const { return ToLongAlgebraic().ToString(); }
+
+    constexpr uint16_t Data() const { return m_Data; }
+    static constexpr PackedMove FromData(uint16_t data) { PackedMove m{}; m.m_Data = data; return m; }  // The inverse of Data()
+
+    constexpr bool operator==(PackedMove other) const { return m_Data == other.m_Data; }
+    constexpr bool operator!=(PackedMove other) const { return m_Data != other.m_Data; }
+private:
+    uint16_t m_Data;
+};
+
+inline std::ostream& operator<<(std::ostream& os, PackedMove m) {
+    os << m.ToString();
+    return os;
+}
+
 using MoveFlags = uint8_t;
 
 namespace MoveFlag {
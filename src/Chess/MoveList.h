@@ -0,0 +1,31 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "Move.h"
+
+// A fixed-size list of moves that lives on the stack (no heap allocations)
+// 256 is more than the most legal moves possible in a position (218)
+// PackedMove isn't initialised on construction, so creating a list costs nothing
+class MoveList {
+public:
+    static constexpr size_t Capacity = 256;
+
+    inline void Add(PackedMove m) { m_Moves[m_Size++] = m; }
+    inline void Clear() { m_Size = 0; }
+
+    inline size_t Size() const { return m_Size; }
+    inline bool Empty() const { return m_Size == 0; }
+
+    inline PackedMove& operator[](size_t i) { return m_Moves[i]; }
+    inline const PackedMove& operator[](size_t i) const { return m_Moves[i]; }
+
+    inline PackedMove* begin() { return m_Moves.data(); }
+    inline PackedMove* end() { return m_Moves.data() + m_Size; }
+    inline const PackedMove* begin() const { return m_Moves.data(); }
+    inline const PackedMove* end() const { return m_Moves.data() + m_Size; }
+private:
+    std::array<PackedMove, Capacity> m_Moves;
+    size_t m_Size = 0;
+};
@@ -0,0 +1,109 @@
+#include "PawnStructure.h"
+
+#include "PseudoLegal.h"
+
+namespace {
+
+    constexpr BitBoard A_FILE = 0x0101010101010101;
+    constexpr BitBoard H_FILE = 0x8080808080808080;
+
+    inline BitBoard East(BitBoard b) { return (b << 1) & ~A_FILE; }
+    inline BitBoard West(BitBoard b) { return (b >> 1) & ~H_FILE; }
+
+    // Every square in front of each pawn (from Us's side), up to the edge of the board
+    template <Colour Us>
+    BitBoard FrontSpans(BitBoard pawns) {
+        if constexpr (Us == White) {
+            pawns |= pawns << 8;
+            pawns |= pawns << 16;
+            pawns |= pawns << 32;
+            return pawns << 8;
+        } else {
+            pawns |= pawns >> 8;
+            pawns |= pawns >> 16;
+            pawns |= pawns >> 32;
+            return pawns >> 8;
+        }
+    }
+
+    // The whole files with a pawn on them
+    BitBoard Files(BitBoard pawns) {
+        return FrontSpans<White>(pawns) | FrontSpans<Black>(pawns) | pawns;
+    }
+
+    template <Colour Us>
+    void AnalyseSide(BitBoard ours, BitBoard theirs, PawnStructure::Features& features) {
+        constexpr Colour Them = OppositeColour(Us);
+        constexpr BitBoard ShieldRanks = Us == White ? 0x0000000000FFFF00 : 0x00FFFF0000000000;
+
+        const BitBoard ourFiles = Files(ours);
+        const BitBoard theirFrontSpans = FrontSpans<Them>(theirs);
+        const BitBoard theirAttacks = PseudoLegal::PawnWestAttacks<Them>(theirs) | PseudoLegal::PawnEastAttacks<Them>(theirs);
+
+        // The squares our pawns could defend if they moved forward
+        const BitBoard ourFrontSpans = FrontSpans<Us>(ours);
+        const BitBoard ourAttackSpans = East(ourFrontSpans) | West(ourFrontSpans);
+
+        features.Passed[Us] = ours & ~(theirFrontSpans | East(theirFrontSpans) | West(theirFrontSpans));
+        features.Isolated[Us] = ours & ~(East(ourFiles) | West(ourFiles));
+        features.Doubled[Us] = ours & FrontSpans<Us>(ours);
+
+        // The pawns with a stop square guarded by an enemy pawn, that no pawn of ours can guard
+        const BitBoard stops = PseudoLegal::PawnPushes<Us>(ours);
+        features.Backward[Us] = PseudoLegal::PawnPushes<Them>(stops & theirAttacks & ~ourAttackSpans);
+
+        features.Shield[Us] = ours & ShieldRanks;
+        features.Attacks[Us] = PseudoLegal::PawnWestAttacks<Us>(ours) | PseudoLegal::PawnEastAttacks<Us>(ours);
+    }
+
+}
+
+namespace PawnStructure {
+
+    Features Analyse(BitBoard whitePawns, BitBoard blackPawns) {
+        Features features;
+        AnalyseSide<White>(whitePawns, blackPawns, features);
+        AnalyseSide<Black>(blackPawns, whitePawns, features);
+        return features;
+    }
+
+    BitBoard ShieldZone(Square king, Colour colour) {
+        BitBoard files = 1ull << king;
+        files |= East(files) | West(files);
+
+        if (colour == White)
+            return (files << 8) | (files << 16);
+
+        return (files >> 8) | (files >> 16);
+    }
+
+    Cache::Cache(size_t entries) {
+        size_t size = 1;
+        while (size * 2 <= entries)
+            size *= 2;
+
+        m_Entries.resize(size);
+        m_Mask = size - 1;
+    }
+
+    const Features& Cache::Probe(const Board& board) {
+        const uint64_t key = board.PawnHash();
+        Entry& entry = m_Entries[key & m_Mask];
+
+        if (entry.Key == key) {
+            m_Hits++;
+            return entry.Value;
+        }
+
+        m_Misses++;
+        entry.Key = key;
+        entry.Value = Analyse(board.Pieces(Pawn, White), board.Pieces(Pawn, Black));
+        return entry.Value;
+    }
+
+    Cache& Cache::ForThisThread() {
+        thread_local Cache s_Cache;
+        return s_Cache;
+    }
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "Board.h"
+
+// Pawn structure analysis, for all the pawns of a side at once with shifts and fills
+// The results only depend on the pawns, and the same pawn structures come up again and again
+// (the pawns move far less often than the pieces), so they are cached by Board::PawnHash()
+// https://www.chessprogramming.org/Pawn_Structure
+
+namespace PawnStructure {
+
+    // Each bitboard is indexed by the colour of the pawns
+    struct Features {
+        std::array<BitBoard, ColourCount> Passed = {};    // No enemy pawn in front of them on the same or an adjacent file
+        std::array<BitBoard, ColourCount> Isolated = {};  // No friendly pawn on an adjacent file
+        std::array<BitBoard, ColourCount> Doubled = {};   // A friendly pawn behind them on the same file (one for each extra pawn)
+        std::array<BitBoard, ColourCount> Backward = {};  // No friendly pawn can defend them, and an enemy pawn guards the square in front
+        std::array<BitBoard, ColourCount> Shield = {};    // On the two ranks in front of the back rank, where they can shelter a castled king
+        std::array<BitBoard, ColourCount> Attacks = {};   // The squares attacked by the pawns
+    };
+
+    Features Analyse(BitBoard whitePawns, BitBoard blackPawns);
+
+    // The squares of the pawns that shelter a king of 'colour' on 'king':
+    // the two ranks in front of it, on its file and the files next to it
+    // AND it with Features::Shield to get the pawns actually there
+    BitBoard ShieldZone(Square king, Colour colour);
+
+    // Analyse() results by pawn hash, with one entry for each hash (the last one analysed)
+    // It isn't thread safe, so each thread should have its own (see ForThisThread())
+    class Cache {
+    public:
+        explicit Cache(size_t entries = 4096);  // Rounded down to a power of two
+
+        // Returns the features of the pawns of 'board', analysing them only if they aren't cached
+        const Features& Probe(const Board& board);
+
+        inline uint64_t Hits() const { return m_Hits; }
+        inline uint64_t Misses() const { return m_Misses; }
+
+        // A cache for the calling thread, created on first use
+        static Cache& ForThisThread();
+    private:
+        // An empty entry has a key of 0, which is the key of a board without pawns, and has no features,
+        // which is right for a board without pawns, so it doesn't need to be marked as empty
+        struct Entry {
+            uint64_t Key = 0;
+            Features Value;
+        };
+
+        std::vector<Entry> m_Entries;
+        uint64_t m_Mask = 0;
+
+        uint64_t m_Hits = 0;
+        uint64_t m_Misses = 0;
+    };
+
+}
@@ -1,9 +1,36 @@
 #include "PseudoLegal.h"
 
 #include <array>
-
-// Source:
+#include <vector>
+
+#if defined(CHESS_PEXT_BITBOARDS)
+    #include <immintrin.h>
+
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+        #define PEXT_TARGET
+    #else
+        // Lets the compiler use BMI2 instructions in this function only,
+        // so the rest of the program still runs on CPUs without BMI2
+        #define PEXT_TARGET __attribute__((target("bmi2")))
+    #endif
+#endif
+
+#if defined(CHESS_AVX2_ATTACKS)
+    #include <immintrin.h>
+
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+        #define AVX2_TARGET
+    #else
+        #define AVX2_TARGET __attribute__((target("avx2")))
+    #endif
+#endif
+
+// Sources:
 // https://www.chessprogramming.org/Kindergarten_Bitboards
+// https://www.chessprogramming.org/Magic_Bitboards
+// https://www.chessprogramming.org/Kogge-Stone_Algorithm
 //
 
 namespace {
@@ -41,29 +68,33 @@ namespace {
     {
         std::array<BitBoard, 64> result = { 0 };
 
-        for (Square s = 8; s < 56; s++) {
+        // Pawns never stand on the first or last rank, but the attacks from
+        // those squares are needed to find pawns attacking a king on them
+        for (Square s = 0; s < 64; s++) {
             // White pawns
-            // Diagonal captures
-            if (RankOf(s + 8) == RankOf(s + 9) && (s + 9) < 64)
-                result[s] |= 1ull << (s + 9);
-            if (RankOf(s + 8) == RankOf(s + 7) && (s + 7) < 64)
-                result[s] |= 1ull << (s + 7);
-            // Calculates the square in front of the pawn
-            if (s + 8 < 64)
+            if (s < 56) {
+                // Diagonal captures
+                if (RankOf(s + 8) == RankOf(s + 9))
+                    result[s] |= 1ull << (s + 9);
+                if (RankOf(s + 8) == RankOf(s + 7))
+                    result[s] |= 1ull << (s + 7);
+                // Calculates the square in front of the pawn
                 result[s] |= 1ull << (s + 8);
+            }
             // Calculates two squares in frot of the pawn for only the first push
             if ((1ull << s) & 0x000000000000FF00)
                 result[s] |= 1ull << (s + 16);
 
             // Black pawns
-            // Diagonal captures
-            if (RankOf(s - 8) == RankOf(s - 9) && (s - 9) < 64)
-                result[s] |= 1ull << (s - 9);
-            if (RankOf(s - 8) == RankOf(s - 7) && (s - 7) < 64)
-                result[s] |= 1ull << (s - 7);
-            // Calculates one square in front of the pawn
-            if (s - 8 < 64)
+            if (s >= 8) {
+                // Diagonal captures
+                if (RankOf(s - 8) == RankOf(s - 9))
+                    result[s] |= 1ull << (s - 9);
+                if (RankOf(s - 8) == RankOf(s - 7))
+                    result[s] |= 1ull << (s - 7);
+                // Calculates one square in front of the pawn
                 result[s] |= 1ull << (s - 8);
+            }
             // Calculates two squares in frot of the pawn for only the first push
             if ((1ull << s) & 0x00FF000000000000)
                 result[s] |= 1ull << (s - 16);
@@ -72,6 +103,23 @@ namespace {
         return result;
     }();
 
+    // The two capture squares of a pawn, indexed by colour and square
+    // (the captures in 'pawns', split by colour so no mask is needed)
+    constexpr std::array<std::array<BitBoard, 64>, ColourCount> pawnAttacks = []() -> auto
+    {
+        std::array<std::array<BitBoard, 64>, ColourCount> result = {};
+
+        for (Square s = 0; s < 64; s++) {
+            const BitBoard square = 1ull << s;
+            const BitBoard notSameFile = pawns[s] & ~BitBoardFile(s);
+
+            result[White][s] = notSameFile & ~(square - 1);
+            result[Black][s] = notSameFile & (square - 1);
+        }
+
+        return result;
+    }();
+
     constexpr std::array<BitBoard, 64> knights = []() -> auto
     {
         std::array<BitBoard, 64> result = { 0 };
@@ -204,6 +252,45 @@ namespace {
         return result;
     }();
 
+    // Indexed by two squares: the squares strictly between them, and the whole line through them (edge to edge)
+    // Both are 0 if the squares aren't on the same file, rank or diagonal
+    struct LineTables {
+        std::array<std::array<BitBoard, 64>, 64> Between = {};
+        std::array<std::array<BitBoard, 64>, 64> Through = {};
+    };
+
+    constexpr LineTables lines = []() -> auto
+    {
+        LineTables result;
+
+        // File and rank steps for the 8 directions a slider can move in
+        constexpr int8_t s_Directions[8][2] = {
+            { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 }, { 1, 1 }, { -1, -1 }, { 1, -1 }, { -1, 1 }
+        };
+
+        auto onBoard = [](int file, int rank) { return file >= 0 && file < 8 && rank >= 0 && rank < 8; };
+
+        for (Square a = 0; a < 64; a++) {
+            for (const auto& [fileStep, rankStep] : s_Directions) {
+                // The line goes in both directions from 'a'
+                BitBoard line = 1ull << a;
+                for (int sign = -1; sign <= 1; sign += 2)
+                    for (int file = FileOf(a) + sign * fileStep, rank = RankOf(a) + sign * rankStep; onBoard(file, rank); file += sign * fileStep, rank += sign * rankStep)
+                        line |= 1ull << (rank * 8 + file);
+
+                BitBoard between = 0;
+                for (int file = FileOf(a) + fileStep, rank = RankOf(a) + rankStep; onBoard(file, rank); file += fileStep, rank += rankStep) {
+                    const Square b = rank * 8 + file;
+                    result.Between[a][b] = between;
+                    result.Through[a][b] = line;
+                    between |= 1ull << b;
+                }
+            }
+        }
+
+        return result;
+    }();
+
     constexpr std::array<BitBoard, 64> kings = []() -> auto
     {
         std::array<BitBoard, 64> result = { 0 };
@@ -266,15 +353,391 @@ namespace {
 
 
 
+namespace PseudoLegal::Kindergarten {
+
+    BitBoard BishopAttack(Square square, BitBoard blockers) {
+        return DiagonalAttack(square, blockers) | AntiDiagonalAttack(square, blockers);
+    }
+
+    BitBoard RookAttack(Square square, BitBoard blockers) {
+        return HorizontalAttack(square, blockers) | VerticalAttack(square, blockers);
+    }
+
+} // namespace PseudoLegal::Kindergarten
+
+
+
+namespace {
+
+    // Fixed-shift magic bitboards: every square uses the same shift (and table size),
+    // so a lookup is one AND, one multiply, one shift and one load
+    constexpr uint32_t ROOK_SHIFT = 64 - 12;
+    constexpr uint32_t BISHOP_SHIFT = 64 - 9;
+
+    constexpr std::array<BitBoard, 64> rookMagics = {
+        0x8080102040008000ull, 0x042002000800D020ull, 0x00A0180301200040ull, 0x9200200A00080442ull,
+        0x6010100400016211ull, 0x00A00100A0040058ull, 0x822001804200010Cull, 0x2480044880002100ull,
+        0xC000088040102100ull, 0x8E08040020884202ull, 0x003C080209008480ull, 0x130080020C008204ull,
+        0x0200081028840604ull, 0x8041100080040045ull, 0x4040104001861110ull, 0x0283400082440560ull,
+        0x20104004C0082010ull, 0x20008B1000102000ull, 0x001820026000E04Cull, 0x0002000810044082ull,
+        0x8010152002080020ull, 0x5440200801008040ull, 0x800200900CC00814ull, 0x0100018000423100ull,
+        0x1001004048008200ull, 0x0012800801240800ull, 0x0011010020812840ull, 0x000140B200061060ull,
+        0x6200020028100410ull, 0x100001004001EC40ull, 0x0020010280840402ull, 0x4002240801100022ull,
+        0x004010A100088100ull, 0x0240160800118400ull, 0x0120014060020804ull, 0x1100020004100800ull,
+        0x900C810412000220ull, 0x4A00A90048201020ull, 0x004A029C00400101ull, 0x21002300800C0C42ull,
+        0xA000631410002001ull, 0x0400101804003000ull, 0x200048042A400800ull, 0x04C2001000B00300ull,
+        0x32101100C148C800ull, 0x0084150000801A08ull, 0x0000848801502200ull, 0x0290110040002C80ull,
+        0x1000480020108080ull, 0x0C80413021006A00ull, 0x1001040812248600ull, 0x0002800400106010ull,
+        0x0000C1000200B230ull, 0x020400490000A100ull, 0x2021801488402003ull, 0x459000400C002008ull,
+        0x2001001600A24082ull, 0x01414044A0100882ull, 0x00010B2A02400582ull, 0x0000400422000A02ull,
+        0x1220512030085422ull, 0x8010B0A086000102ull, 0x0440010200B04804ull, 0x440A040100402082ull
+    };
+
+    constexpr std::array<BitBoard, 64> bishopMagics = {
+        0xC01008C011284280ull, 0x4001100200C00519ull, 0x00040800810808A0ull, 0x0021203004190200ull,
+        0x0950809200002040ull, 0x0200160020041004ull, 0x0140208820100210ull, 0x1102089402008883ull,
+        0x00A8030414041011ull, 0x2000140016220424ull, 0x04003000200820E0ull, 0x1802020821000000ull,
+        0x0482020084009C10ull, 0x0880004908004410ull, 0x28120054A0200400ull, 0x2011108010412008ull,
+        0x0100492545040C00ull, 0x4040480414005200ull, 0x804800150100050Eull, 0x1208001008440420ull,
+        0x1024020480A01400ull, 0x3600C00823020330ull, 0x0820400144401201ull, 0x0000B00004000800ull,
+        0x001004194A880040ull, 0x1000103020602180ull, 0x4445004404081808ull, 0x0101004024040002ull,
+        0x0019010008104000ull, 0x49101080000A0040ull, 0x00C8014801104400ull, 0x48800A00080900C0ull,
+        0x1002008200620068ull, 0x0C0084804C100040ull, 0x6440080408020021ull, 0x0009010800310040ull,
+        0x2C34180200002008ull, 0x000080EC10420107ull, 0x1001202160044300ull, 0x0080D00A40040280ull,
+        0x020202A000C00280ull, 0x1001801050000203ull, 0x000008A400801000ull, 0x0045010080812008ull,
+        0x8100024140C09010ull, 0x48400106A0200700ull, 0x1201020801044208ull, 0x48080044400408C0ull,
+        0x0200C14028080000ull, 0x8000020890A00000ull, 0x8C500008A010000Aull, 0x012C840004043000ull,
+        0x200000103A009100ull, 0x8002046000214000ull, 0x0004005000620018ull, 0x1080886084080400ull,
+        0x4105010080109240ull, 0x0000008040501202ull, 0x0400801004808940ull, 0x44100020204008B8ull,
+        0x8000280024501408ull, 0x018008042000D900ull, 0x2050AC01C1880010ull, 0x000041080204006Cull
+    };
+
+    // The squares that can block a slider, not counting the edge of the board
+    // (a piece on the edge doesn't change the attacks)
+    constexpr std::array<BitBoard, 64> rookMasks = []() -> auto
+    {
+        std::array<BitBoard, 64> result = { 0 };
+
+        for (Square s = 0; s < 64; s++) {
+            BitBoard rank = 0x00000000000000FFull << (s & 0b00111000);
+            BitBoard file = A_FILE << (s & 0b00000111);
+            result[s] = ((rank & 0x7E7E7E7E7E7E7E7E) | (file & 0x00FFFFFFFFFFFF00)) & ~(1ull << s);
+        }
+
+        return result;
+    }();
+
+    constexpr std::array<BitBoard, 64> bishopMasks = []() -> auto
+    {
+        std::array<BitBoard, 64> result = { 0 };
+
+        for (Square s = 0; s < 64; s++)
+            result[s] = (diagonals[s] | antiDiagonals[s]) & 0x007E7E7E7E7E7E00;
+
+        return result;
+    }();
+
+    // 2.25 MB of lookup tables, filled in at startup from the kindergarten attacks
+    struct MagicTables {
+        std::array<std::array<BitBoard, 1 << (64 - ROOK_SHIFT)>, 64> RookAttacks;
+        std::array<std::array<BitBoard, 1 << (64 - BISHOP_SHIFT)>, 64> BishopAttacks;
+
+        MagicTables() {
+            for (Square s = 0; s < 64; s++) {
+                // Loop through every subset of the mask (Carry-Rippler)
+                BitBoard blockers = 0;
+                do {
+                    RookAttacks[s][(blockers * rookMagics[s]) >> ROOK_SHIFT] = PseudoLegal::Kindergarten::RookAttack(s, blockers);
+                    blockers = (blockers - rookMasks[s]) & rookMasks[s];
+                } while (blockers);
+
+                do {
+                    BishopAttacks[s][(blockers * bishopMagics[s]) >> BISHOP_SHIFT] = PseudoLegal::Kindergarten::BishopAttack(s, blockers);
+                    blockers = (blockers - bishopMasks[s]) & bishopMasks[s];
+                } while (blockers);
+            }
+        }
+    };
+
+    const MagicTables magicTables;
+
+} // anonymous namespace
+
+
+
+namespace PseudoLegal::Magic {
+
+    BitBoard BishopAttack(Square square, BitBoard blockers) {
+        return magicTables.BishopAttacks[square][((blockers & bishopMasks[square]) * bishopMagics[square]) >> BISHOP_SHIFT];
+    }
+
+    BitBoard RookAttack(Square square, BitBoard blockers) {
+        return magicTables.RookAttacks[square][((blockers & rookMasks[square]) * rookMagics[square]) >> ROOK_SHIFT];
+    }
+
+} // namespace PseudoLegal::Magic
+
+
+
+#if defined(CHESS_PEXT_BITBOARDS)
+
+namespace {
+
+    bool CpuSupportsBmi2() {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuidex(info, 7, 0);
+        return info[1] & (1 << 8);  // EBX bit 8
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("bmi2");
+#endif
+    }
+
+    // Where the attacks of each square start in PextTables::Attacks
+    // Each square has 2^(mask bits) entries, 102400 for rooks and 5248 for bishops
+    struct PextOffsets {
+        std::array<uint32_t, 64> Rook = { 0 };
+        std::array<uint32_t, 64> Bishop = { 0 };
+        uint32_t Size = 0;
+    };
+
+    constexpr PextOffsets pextOffsets = []() -> auto
+    {
+        auto bitCount = [](BitBoard b) {
+            uint32_t count = 0;
+            for (; b; b &= b - 1)
+                count++;
+            return count;
+        };
+
+        PextOffsets offsets;
+        for (Square s = 0; s < 64; s++) {
+            offsets.Rook[s] = offsets.Size;
+            offsets.Size += 1u << bitCount(rookMasks[s]);
+            offsets.Bishop[s] = offsets.Size;
+            offsets.Size += 1u << bitCount(bishopMasks[s]);
+        }
+
+        return offsets;
+    }();
+
+    // PEXT gathers the blocker bits under the mask into a dense index,
+    // so no magic numbers are needed and the table is 840 KB instead of 2.25 MB
+    // It's only filled in if the CPU supports BMI2
+    struct PextTables {
+        const bool Supported = CpuSupportsBmi2();
+        std::array<BitBoard, pextOffsets.Size> Attacks;
+
+        PextTables() {
+            if (Supported)
+                Fill();
+        }
+
+        PEXT_TARGET void Fill() {
+            for (Square s = 0; s < 64; s++) {
+                BitBoard blockers = 0;
+                do {
+                    Attacks[pextOffsets.Rook[s] + _pext_u64(blockers, rookMasks[s])] = PseudoLegal::Kindergarten::RookAttack(s, blockers);
+                    blockers = (blockers - rookMasks[s]) & rookMasks[s];
+                } while (blockers);
+
+                do {
+                    Attacks[pextOffsets.Bishop[s] + _pext_u64(blockers, bishopMasks[s])] = PseudoLegal::Kindergarten::BishopAttack(s, blockers);
+                    blockers = (blockers - bishopMasks[s]) & bishopMasks[s];
+                } while (blockers);
+            }
+        }
+    };
+
+    PextTables pextTables;
+
+} // anonymous namespace
+
+namespace PseudoLegal::Pext {
+
+    bool IsSupported() {
+        return pextTables.Supported;
+    }
+
+    PEXT_TARGET BitBoard BishopAttack(Square square, BitBoard blockers) {
+        return pextTables.Attacks[pextOffsets.Bishop[square] + _pext_u64(blockers, bishopMasks[square])];
+    }
+
+    PEXT_TARGET BitBoard RookAttack(Square square, BitBoard blockers) {
+        return pextTables.Attacks[pextOffsets.Rook[square] + _pext_u64(blockers, rookMasks[square])];
+    }
+
+} // namespace PseudoLegal::Pext
+
+#endif
+
+
+
+namespace PseudoLegal::KoggeStone {
+
+    namespace {
+
+        constexpr BitBoard NOT_A_FILE = ~A_FILE;
+        constexpr BitBoard NOT_H_FILE = ~(A_FILE << 7);
+
+        // Fills from the 'sliders' towards the higher squares, 'shift' squares per step, stopping at blockers
+        // 'mask' removes the squares that wrapped around the edge of the board
+        // The fill doubles its reach every step (1, 2 then 4 squares), so 3 steps cover the 7 squares of a line
+        inline BitBoard FillUp(BitBoard sliders, BitBoard empty, int shift, BitBoard mask) {
+            empty &= mask;
+            sliders |= empty & (sliders << shift);
+            empty &= empty << shift;
+            sliders |= empty & (sliders << 2 * shift);
+            empty &= empty << 2 * shift;
+            sliders |= empty & (sliders << 4 * shift);
+
+            // One more step onto the blockers
+            return (sliders << shift) & mask;
+        }
+
+        // The same towards the lower squares
+        inline BitBoard FillDown(BitBoard sliders, BitBoard empty, int shift, BitBoard mask) {
+            empty &= mask;
+            sliders |= empty & (sliders >> shift);
+            empty &= empty >> shift;
+            sliders |= empty & (sliders >> 2 * shift);
+            empty &= empty >> 2 * shift;
+            sliders |= empty & (sliders >> 4 * shift);
+
+            return (sliders >> shift) & mask;
+        }
+
+    } // anonymous namespace
+
+    BitBoard SliderAttacks(BitBoard bishops, BitBoard rooks, BitBoard blockers) {
+        const BitBoard empty = ~blockers;
+
+        return FillUp(rooks, empty, 8, ~0ull)           // North
+            | FillDown(rooks, empty, 8, ~0ull)          // South
+            | FillUp(rooks, empty, 1, NOT_A_FILE)       // East
+            | FillDown(rooks, empty, 1, NOT_H_FILE)     // West
+            | FillUp(bishops, empty, 9, NOT_A_FILE)     // North east
+            | FillUp(bishops, empty, 7, NOT_H_FILE)     // North west
+            | FillDown(bishops, empty, 7, NOT_A_FILE)   // South east
+            | FillDown(bishops, empty, 9, NOT_H_FILE);  // South west
+    }
+
+} // namespace PseudoLegal::KoggeStone
+
+
+
+#if defined(CHESS_AVX2_ATTACKS)
+
+namespace {
+
+    bool CpuSupportsAvx2() {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        const bool osSavesYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;  // OSXSAVE, and the OS saves the AVX registers
+        __cpuidex(info, 7, 0);
+        return osSavesYmm && (info[1] & (1 << 5));  // EBX bit 5
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+
+    const bool avx2Supported = CpuSupportsAvx2();
+
+} // anonymous namespace
+
+namespace PseudoLegal::Avx2 {
+
+    bool IsSupported() {
+        return avx2Supported;
+    }
+
+    // The same fills as KoggeStone::SliderAttacks(), with one direction in each 64-bit lane
+    // One vector holds the 4 directions that shift up (north, east, north east, north west)
+    // and the other the 4 that shift down, and the 8 lanes are ORed together at the end
+    AVX2_TARGET BitBoard SliderAttacks(BitBoard bishops, BitBoard rooks, BitBoard blockers) {
+        const __m256i shift1 = _mm256_set_epi64x(7, 9, 1, 8);
+        const __m256i shift2 = _mm256_add_epi64(shift1, shift1);
+        const __m256i shift4 = _mm256_add_epi64(shift2, shift2);
+
+        const __m256i upMask = _mm256_set_epi64x(~(A_FILE << 7), ~A_FILE, ~A_FILE, -1);
+        const __m256i downMask = _mm256_set_epi64x(~A_FILE, ~(A_FILE << 7), ~(A_FILE << 7), -1);
+
+        const __m256i sliders = _mm256_set_epi64x(bishops, bishops, rooks, rooks);
+        const __m256i empty = _mm256_set1_epi64x(~blockers);
+
+        // Up
+        __m256i up = sliders;
+        __m256i upEmpty = _mm256_and_si256(empty, upMask);
+        up = _mm256_or_si256(up, _mm256_and_si256(upEmpty, _mm256_sllv_epi64(up, shift1)));
+        upEmpty = _mm256_and_si256(upEmpty, _mm256_sllv_epi64(upEmpty, shift1));
+        up = _mm256_or_si256(up, _mm256_and_si256(upEmpty, _mm256_sllv_epi64(up, shift2)));
+        upEmpty = _mm256_and_si256(upEmpty, _mm256_sllv_epi64(upEmpty, shift2));
+        up = _mm256_or_si256(up, _mm256_and_si256(upEmpty, _mm256_sllv_epi64(up, shift4)));
+        up = _mm256_and_si256(_mm256_sllv_epi64(up, shift1), upMask);
+
+        // Down (the masks differ, as a diagonal that goes east when shifting up goes west when shifting down)
+        __m256i down = sliders;
+        __m256i downEmpty = _mm256_and_si256(empty, downMask);
+        down = _mm256_or_si256(down, _mm256_and_si256(downEmpty, _mm256_srlv_epi64(down, shift1)));
+        downEmpty = _mm256_and_si256(downEmpty, _mm256_srlv_epi64(downEmpty, shift1));
+        down = _mm256_or_si256(down, _mm256_and_si256(downEmpty, _mm256_srlv_epi64(down, shift2)));
+        downEmpty = _mm256_and_si256(downEmpty, _mm256_srlv_epi64(downEmpty, shift2));
+        down = _mm256_or_si256(down, _mm256_and_si256(downEmpty, _mm256_srlv_epi64(down, shift4)));
+        down = _mm256_and_si256(_mm256_srlv_epi64(down, shift1), downMask);
+
+        const __m256i attacks = _mm256_or_si256(up, down);
+        const __m128i halves = _mm_or_si128(_mm256_castsi256_si128(attacks), _mm256_extracti128_si256(attacks, 1));
+        return _mm_cvtsi128_si64(halves) | _mm_extract_epi64(halves, 1);
+    }
+
+} // namespace PseudoLegal::Avx2
+
+#endif
+
+
+
+namespace {
+
+    // The slider attack implementation, picked once at startup so calls don't check the CPU every time
+    struct SliderBackend {
+        BitBoard (*BishopAttack)(Square square, BitBoard blockers);
+        BitBoard (*RookAttack)(Square square, BitBoard blockers);
+        std::string_view Name;
+    };
+
+    SliderBackend PickSliderBackend() {
+#if defined(CHESS_PEXT_BITBOARDS)
+        if (pextTables.Supported)
+            return { PseudoLegal::Pext::BishopAttack, PseudoLegal::Pext::RookAttack, "PEXT bitboards (BMI2)" };
+#endif
+
+#if defined(CHESS_MAGIC_BITBOARDS)
+        return { PseudoLegal::Magic::BishopAttack, PseudoLegal::Magic::RookAttack, "magic bitboards" };
+#else
+        return { PseudoLegal::Kindergarten::BishopAttack, PseudoLegal::Kindergarten::RookAttack, "kindergarten bitboards" };
+#endif
+    }
+
+    // Defined after the tables, so it's initialised after them
+    const SliderBackend s_SliderBackend = PickSliderBackend();
+
+} // anonymous namespace
+
+
+
 namespace PseudoLegal {
 
-    BitBoard PawnMoves(Square square, Colour colour, BitBoard blockers, Square enPassant) {
+    template <Colour Us>
+    BitBoard PawnMoves(Square square, BitBoard blockers, Square enPassant) {
         // Since the 'pawns' bitboard returns the pawn moves
         // for both colours, a mask is used to get only the
         // moves according to the colour that is moving
         BitBoard colourMask = (1ull << square) - 1;
 
-        if (colour == White) {
+        if constexpr (Us == White) {
             colourMask = ~colourMask;
             blockers |= (blockers << 8) & (1ull << (square + 16));
         } else {
@@ -287,7 +750,9 @@ namespace PseudoLegal {
         // The square doesn't actually block the pawn, which is
         // why it is added after the above if-statement
         // (Blockers are attacked by pawns)
-        blockers |= 1ull << enPassant;
+        // A square of 0 means there is no en passant square
+        if (enPassant != 0)
+            blockers |= 1ull << enPassant;
 
         pawnMoves &= ~(blockers & BitBoardFile(square));
         pawnMoves &= ~(blockers ^ ~BitBoardFile(square));
@@ -295,12 +760,29 @@ namespace PseudoLegal {
         return pawnMoves;
     }
 
+    template <Colour Us>
+    BitBoard PawnAttack(Square square) {
+        return pawnAttacks[Us][square];
+    }
+
+    template BitBoard PawnMoves<White>(Square square, BitBoard blockers, Square enPassant);
+    template BitBoard PawnMoves<Black>(Square square, BitBoard blockers, Square enPassant);
+    template BitBoard PawnAttack<White>(Square square);
+    template BitBoard PawnAttack<Black>(Square square);
+
+    BitBoard PawnMoves(Square square, Colour colour, BitBoard blockers, Square enPassant) {
+        return colour == White ? PawnMoves<White>(square, blockers, enPassant) : PawnMoves<Black>(square, blockers, enPassant);
+    }
+
     BitBoard PawnAttack(Square square, Colour colour) {
-        // Same as this
-        //BitBoard colourMask = (colour == White) ? ~((1ull << square) - 1) : ((1ull << square) - 1);
-        BitBoard colourMask = ~(colour * 0xFFFFFFFFFFFFFFFF) ^ ((1ull << square) - 1);
-        BitBoard pawnMoves = pawns[square] & colourMask;
-        return pawnMoves & ~BitBoardFile(square);
+        return pawnAttacks[colour][square];
+    }
+
+    BitBoard PawnAttacks(BitBoard pawns, Colour colour) {
+        if (colour == White)
+            return PawnWestAttacks<White>(pawns) | PawnEastAttacks<White>(pawns);
+
+        return PawnWestAttacks<Black>(pawns) | PawnEastAttacks<Black>(pawns);
     }
 
     BitBoard KnightAttack(Square square) {
@@ -308,11 +790,24 @@ namespace PseudoLegal {
     }
 
     BitBoard BishopAttack(Square square, BitBoard blockers) {
-        return DiagonalAttack(square, blockers) | AntiDiagonalAttack(square, blockers);
+        return s_SliderBackend.BishopAttack(square, blockers);
     }
 
     BitBoard RookAttack(Square square, BitBoard blockers) {
-        return HorizontalAttack(square, blockers) | VerticalAttack(square, blockers);
+        return s_SliderBackend.RookAttack(square, blockers);
+    }
+
+    std::string_view SliderAttackName() {
+        return s_SliderBackend.Name;
+    }
+
+    BitBoard SliderAttacks(BitBoard bishops, BitBoard rooks, BitBoard blockers) {
+#if defined(CHESS_AVX2_ATTACKS)
+        if (avx2Supported)
+            return Avx2::SliderAttacks(bishops, rooks, blockers);
+#endif
+
+        return KoggeStone::SliderAttacks(bishops, rooks, blockers);
     }
 
     BitBoard QueenAttack(Square square, BitBoard blockers) {
@@ -323,32 +818,12 @@ namespace PseudoLegal {
         return kings[square];
     }
 
-    BitBoard Line(BitBoard square1, BitBoard square2) {
-        // Only count the least significant bit, in case there are multiple bits set
-        square1 &= (~square1) + 1;
-        square2 &= (~square2) + 1;
-
-        // If one of them is 0, return 0
-        if (square1 && square2 == 0)
-            return 0;
-
-        BitBoard inBetween = (square1 - 1) ^ (square2 - 1);  // Gets all the squares between square1 and square2
-        inBetween |= (square1 | square2);  // Include both squares; the larger one will disappear
-
-        // Gets the relevant squares
-        Square s1 = GetSquare(square1);
-        Square s2 = GetSquare(square2);
-
-        if (FileOf(s1) == FileOf(s2))
-            return inBetween & BitBoardFile(s1);
-        if (RankOf(s1) == RankOf(s2))
-            return inBetween & BitBoardRank(s1);
-        if (diagonals[s1] & square2)
-            return inBetween & diagonals[s1];
-        if (antiDiagonals[s1] & square2)
-            return inBetween & antiDiagonals[s1];
+    BitBoard Between(Square a, Square b) {
+        return lines.Between[a][b];
+    }
 
-        return 0;
+    BitBoard LineThrough(Square a, Square b) {
+        return lines.Through[a][b];
     }
 
 } // namespace PseudoLegal
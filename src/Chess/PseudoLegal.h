@@ -1,7 +1,22 @@
 #pragma once
 
+#include <string_view>
+
 #include "BitBoard.h"
 
+// PEXT (from BMI2) slider attacks are compiled in if CHESS_PEXT_BITBOARDS is defined (x86-64 only),
+// and used if the CPU supports them (checked at startup)
+// They are off by default, as they measured no faster than magic bitboards
+#if defined(CHESS_PEXT_BITBOARDS) && !(defined(__x86_64__) || defined(_M_X64))
+    #undef CHESS_PEXT_BITBOARDS
+#endif
+
+// AVX2 set-wise slider attacks are compiled in on x86-64, and used
+// if the CPU supports them (checked at startup)
+#if !defined(CHESS_NO_AVX2_ATTACKS) && (defined(__x86_64__) || defined(_M_X64))
+    #define CHESS_AVX2_ATTACKS
+#endif
+
 namespace PseudoLegal {
 
     /**
@@ -12,6 +27,9 @@ namespace PseudoLegal {
      */
     BitBoard PawnAttack(Square square, Colour colour);
 
+    // Returns every square attacked by the 'pawns' of 'colour' (all at once, with shifts)
+    BitBoard PawnAttacks(BitBoard pawns, Colour colour);
+
     /**
      * \brief gets all the pawn moves (captures, forward moves, en-passant)
      * \param square the square of the pawn
@@ -22,6 +40,29 @@ namespace PseudoLegal {
      */
     BitBoard PawnMoves(Square square, Colour colour, BitBoard blockers, Square enPassant);
 
+    // The same as above with the colour known at compile time (used by the move generator)
+    template <Colour Us> BitBoard PawnAttack(Square square);
+    template <Colour Us> BitBoard PawnMoves(Square square, BitBoard blockers, Square enPassant);
+
+    // Set-wise pawn moves, for all the 'pawns' of Us at once
+    // The squares one step forward, and the captures towards the a-file (west) and h-file (east)
+    // The Offset is what gets added to a pawn's square to get to the destination
+    template <Colour Us> constexpr int PawnPushOffset = Us == White ? 8 : -8;
+    template <Colour Us> constexpr int PawnWestOffset = Us == White ? 7 : -9;
+    template <Colour Us> constexpr int PawnEastOffset = Us == White ? 9 : -7;
+
+    template <Colour Us> inline BitBoard PawnPushes(BitBoard pawns) {
+        return Us == White ? pawns << 8 : pawns >> 8;
+    }
+
+    template <Colour Us> inline BitBoard PawnWestAttacks(BitBoard pawns) {
+        return (Us == White ? pawns << 7 : pawns >> 9) & ~0x8080808080808080;  // Don't wrap around to the h-file
+    }
+
+    template <Colour Us> inline BitBoard PawnEastAttacks(BitBoard pawns) {
+        return (Us == White ? pawns << 9 : pawns >> 7) & ~0x0101010101010101;  // Don't wrap around to the a-file
+    }
+
     // Note: The bitboards returned include the blockers
 
     BitBoard KnightAttack(Square square);
@@ -30,7 +71,51 @@ namespace PseudoLegal {
     BitBoard QueenAttack(Square square, BitBoard blockers);
     BitBoard KingAttack(Square square);
 
-    // A line (diagonal, vertical, or horizontal) between two squares
-    BitBoard Line(BitBoard square1, BitBoard square2);
+    // Every square attacked by any of the 'bishops' and 'rooks' (queens go in both), all at once
+    // The sliders are filled along each direction together (Kogge-Stone), so there is no loop over the pieces
+    // Uses AVX2 if the CPU supports it, and 64-bit shifts if not
+    BitBoard SliderAttacks(BitBoard bishops, BitBoard rooks, BitBoard blockers);
+
+    // The squares strictly between 'a' and 'b' if they are on the same file, rank or diagonal (0 if not)
+    BitBoard Between(Square a, Square b);
+    // The whole file, rank or diagonal through 'a' and 'b', from edge to edge (0 if they aren't on one)
+    BitBoard LineThrough(Square a, Square b);
+
+    // The slider attack implementations, exposed for benchmarking
+    // BishopAttack() and RookAttack() use PEXT bitboards if CHESS_PEXT_BITBOARDS is defined and the CPU supports BMI2.
+    // Otherwise they use magic bitboards if CHESS_MAGIC_BITBOARDS is defined,
+    // and kindergarten bitboards if not.
+
+    // The name of the implementation picked at startup (for logging)
+    std::string_view SliderAttackName();
+
+    namespace Kindergarten {
+        BitBoard BishopAttack(Square square, BitBoard blockers);  // 2 multiplications and lookups
+        BitBoard RookAttack(Square square, BitBoard blockers);    // 2 multiplications and lookups
+    }
+
+    namespace Magic {
+        BitBoard BishopAttack(Square square, BitBoard blockers);  // 1 multiplication and lookup
+        BitBoard RookAttack(Square square, BitBoard blockers);    // 1 multiplication and lookup
+    }
+
+    namespace KoggeStone {
+        BitBoard SliderAttacks(BitBoard bishops, BitBoard rooks, BitBoard blockers);  // 8 directions, one after another
+    }
+
+#if defined(CHESS_AVX2_ATTACKS)
+    namespace Avx2 {
+        bool IsSupported();  // Only call the function below if this returns true
+        BitBoard SliderAttacks(BitBoard bishops, BitBoard rooks, BitBoard blockers);  // 4 directions at a time
+    }
+#endif
+
+#if defined(CHESS_PEXT_BITBOARDS)
+    namespace Pext {
+        bool IsSupported();  // Only call the functions below if this returns true
+        BitBoard BishopAttack(Square square, BitBoard blockers);  // 1 PEXT and lookup
+        BitBoard RookAttack(Square square, BitBoard blockers);    // 1 PEXT and lookup
+    }
+#endif
 
 }
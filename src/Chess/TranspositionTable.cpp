@@ -0,0 +1,183 @@
+#include "TranspositionTable.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+#if defined(_MSC_VER)
+    #include <malloc.h>
+#elif defined(__linux__)
+    #include <sys/mman.h>
+#endif
+
+namespace {
+
+    void* AllocateTable(size_t bytes) {
+#if defined(_MSC_VER)
+        return _aligned_malloc(bytes, 64);
+#elif defined(__linux__)
+        // Random probes all over a big table miss the TLB on almost every access with 4 KB pages,
+        // so tables of 2 MB or more are aligned to 2 MB and the kernel is asked to back them with huge pages
+        constexpr size_t HugePageSize = 2 * 1024 * 1024;
+        const size_t alignment = bytes >= HugePageSize ? HugePageSize : 64;
+
+        void* memory = std::aligned_alloc(alignment, bytes);  // 'bytes' is a power of two, so a multiple of the alignment
+        if (memory && alignment == HugePageSize)
+            madvise(memory, bytes, MADV_HUGEPAGE);
+
+        return memory;
+#else
+        return std::aligned_alloc(64, bytes);
+#endif
+    }
+
+    void FreeTable(void* memory) {
+#if defined(_MSC_VER)
+        _aligned_free(memory);
+#else
+        std::free(memory);
+#endif
+    }
+
+}
+
+TranspositionTable::TranspositionTable(size_t megabytes) {
+    Resize(megabytes);
+}
+
+TranspositionTable::~TranspositionTable() {
+    Free();
+}
+
+void TranspositionTable::Resize(size_t megabytes) {
+    Free();
+
+    size_t clusters = 1;
+    while (clusters * 2 * sizeof(Cluster) <= megabytes * 1024 * 1024)
+        clusters *= 2;
+
+    void* memory = AllocateTable(clusters * sizeof(Cluster));
+    if (memory == nullptr)
+        throw std::bad_alloc();
+
+    // Constructed one by one: an array placement new may put a size cookie in front of the clusters
+    m_Clusters = static_cast<Cluster*>(memory);
+    std::uninitialized_default_construct_n(m_Clusters, clusters);
+    m_ClusterCount = clusters;
+
+    Clear();
+}
+
+void TranspositionTable::Free() {
+    if (m_Clusters == nullptr)
+        return;
+
+    // The clusters are trivially destructible, so the memory is just given back
+    FreeTable(m_Clusters);
+    m_Clusters = nullptr;
+    m_ClusterCount = 0;
+}
+
+void TranspositionTable::Clear() {
+    for (size_t i = 0; i < m_ClusterCount; i++) {
+        for (EntryData& entry : m_Clusters[i].Entries) {
+            entry.Key.store(0, std::memory_order_relaxed);
+            entry.Data.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    m_Age = 0;
+}
+
+bool TranspositionTable::Probe(uint64_t hash, Entry& entry) const {
+    const Cluster& cluster = m_Clusters[hash & (m_ClusterCount - 1)];
+
+    for (const EntryData& e : cluster.Entries) {
+        const uint64_t key = e.Key.load(std::memory_order_relaxed);
+        const uint64_t data = e.Data.load(std::memory_order_relaxed);
+
+        // Empty entries are all zeros
+        if (data != 0 && (key ^ data) == hash) {
+            entry = Unpack(data);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TranspositionTable::Store(uint64_t hash, PackedMove move, int32_t score, int32_t eval, int32_t depth, Bound bound) {
+    Cluster& cluster = m_Clusters[hash & (m_ClusterCount - 1)];
+
+    EntryData* replace = nullptr;
+    uint64_t replaceData = 0;
+    int32_t lowestValue = INT_MAX;
+
+    for (EntryData& e : cluster.Entries) {
+        const uint64_t key = e.Key.load(std::memory_order_relaxed);
+        const uint64_t data = e.Data.load(std::memory_order_relaxed);
+
+        if (data != 0 && (key ^ data) == hash) {
+            replace = &e;
+            replaceData = data;
+            break;
+        }
+
+        // An empty entry is used first, then the shallowest (each search ago counts as 8 plies less)
+        const int32_t value = data == 0 ? INT_MIN : DepthOf(data) - 8 * RelativeAge(data);
+        if (value < lowestValue) {
+            lowestValue = value;
+            replace = &e;
+            replaceData = data;
+        }
+    }
+
+    const bool sameHash = replaceData != 0 && (replace->Key.load(std::memory_order_relaxed) ^ replaceData) == hash;
+    if (sameHash) {
+        if (bound != Bound::Exact && RelativeAge(replaceData) == 0 && depth < DepthOf(replaceData))
+            return;
+
+        // Keeps the best move of the old search if the new one didn't find one (all the moves failed low)
+        if (move == PackedMove{})
+            move = Unpack(replaceData).Move;
+    }
+
+    const uint64_t data = Pack(move, score, eval, depth, bound, m_Age);
+    replace->Key.store(hash ^ data, std::memory_order_relaxed);
+    replace->Data.store(data, std::memory_order_relaxed);
+}
+
+int32_t TranspositionTable::Hashfull() const {
+    const size_t clusters = std::min<size_t>(m_ClusterCount, 1000);
+
+    size_t used = 0;
+    for (size_t i = 0; i < clusters; i++) {
+        for (const EntryData& e : m_Clusters[i].Entries) {
+            const uint64_t data = e.Data.load(std::memory_order_relaxed);
+            used += data != 0 && RelativeAge(data) == 0;
+        }
+    }
+
+    return (int32_t)(used * 1000 / (clusters * ClusterSize));
+}
+
+uint64_t TranspositionTable::Pack(PackedMove move, int32_t score, int32_t eval, int32_t depth, Bound bound, uint8_t age) {
+    return (uint64_t)move.Data()
+        | (uint64_t)(uint16_t)score << 16
+        | (uint64_t)(uint16_t)eval << 32
+        | (uint64_t)(uint8_t)std::clamp(depth, 0, 255) << 48
+        | (uint64_t)bound << 56
+        | (uint64_t)(age & AgeMask) << 58;
+}
+
+TranspositionTable::Entry TranspositionTable::Unpack(uint64_t data) {
+    Entry entry;
+    entry.Move = PackedMove::FromData((uint16_t)data);
+    entry.Score = (int16_t)(data >> 16);
+    entry.Eval = (int16_t)(data >> 32);
+    entry.Depth = (uint8_t)(data >> 48);
+    entry.ScoreBound = (Bound)((data >> 56) & 3);
+    return entry;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+#include "Move.h"
+
+// A table of search results by position hash (Board::Hash()), which any number of threads can share without locks
+// The entries are in clusters of 4 that fill a cache line, so a probe costs one memory access
+// Each entry stores its key XORed with its data, so an entry torn by two threads writing at once
+// no longer matches its key, and is treated as a miss
+// https://www.chessprogramming.org/Transposition_Table
+// https://www.chessprogramming.org/Shared_Hash_Table#Lockless
+class TranspositionTable {
+public:
+    // What the score of an entry says about the real score of the position
+    enum class Bound : uint8_t {
+        None,
+        Upper,  // The real score is at most Score (no move reached alpha)
+        Lower,  // The real score is at least Score (a move reached beta)
+        Exact,
+    };
+
+    struct Entry {
+        PackedMove Move = {};  // The best move found (0 if there was none)
+        int16_t Score = 0;     // Mate scores are stored as the caller gives them, so they should be relative to the position
+        int16_t Eval = 0;      // The static evaluation
+        uint8_t Depth = 0;
+        Bound ScoreBound = Bound::None;
+    };
+
+    explicit TranspositionTable(size_t megabytes = 16);
+    ~TranspositionTable();
+
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    // Rounded down to a power of two (at least one cluster), and the table is cleared
+    // Not thread safe: no other thread may use the table while it's resized or cleared
+    void Resize(size_t megabytes);
+    void Clear();
+
+    inline size_t Size() const { return m_ClusterCount * sizeof(Cluster); }  // In bytes
+
+    // Call before every search, so the entries of older searches are replaced first
+    void NewSearch() { m_Age = (m_Age + 1) & AgeMask; }
+
+    // Returns true and fills 'entry' if 'hash' is in the table
+    bool Probe(uint64_t hash, Entry& entry) const;
+
+    // Replaces the entry for 'hash' if it's there, otherwise the least useful entry of its cluster
+    // (the shallowest, counting older searches as shallower)
+    // An entry from this search with a deeper search behind it is only replaced by an exact score
+    void Store(uint64_t hash, PackedMove move, int32_t score, int32_t eval, int32_t depth, Bound bound);
+
+    // Starts loading the cluster of 'hash' into the cache, so a probe after making the move doesn't wait for memory
+    inline void Prefetch(uint64_t hash) const {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(&m_Clusters[hash & (m_ClusterCount - 1)]);
+#endif
+    }
+
+    // How full the table is in permille, counting only the entries of this search (from a sample of 1000 clusters)
+    int32_t Hashfull() const;
+private:
+    static constexpr size_t ClusterSize = 4;
+    static constexpr uint8_t AgeMask = 0x3F;  // The age is stored in 6 bits
+
+    struct EntryData {
+        std::atomic<uint64_t> Key;   // The hash XORed with Data
+        std::atomic<uint64_t> Data;  // Entry packed (see Pack())
+    };
+
+    // One cache line
+    struct alignas(64) Cluster {
+        EntryData Entries[ClusterSize];
+    };
+
+    // Bits 0-15: move, 16-31: score, 32-47: eval, 48-55: depth, 56-57: bound, 58-63: age
+    static uint64_t Pack(PackedMove move, int32_t score, int32_t eval, int32_t depth, Bound bound, uint8_t age);
+    static Entry Unpack(uint64_t data);
+    static inline uint8_t AgeOf(uint64_t data) { return (uint8_t)(data >> 58); }
+    // How many searches ago the entry was stored, modulo 64 so that it stays right after the age wraps
+    inline uint8_t RelativeAge(uint64_t data) const { return (m_Age - AgeOf(data)) & AgeMask; }
+    static inline int32_t DepthOf(uint64_t data) { return (uint8_t)(data >> 48); }
+
+    void Free();
+private:
+    Cluster* m_Clusters = nullptr;
+    size_t m_ClusterCount = 0;  // A power of two
+    uint8_t m_Age = 0;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+
+#include "BitBoard.h"
+
+// Random keys used to hash positions
+// The hash of a position is all the keys of its features XORed together,
+// so it can be updated by XORing the keys of whatever changes after a move
+// https://www.chessprogramming.org/Zobrist_Hashing
+
+namespace Zobrist {
+
+    struct Keys {
+        std::array<std::array<uint64_t, 64>, 16> Pieces = {};  // Indexed by Piece and Square
+        std::array<uint64_t, 16> Castling = {};                // Indexed by the castling rights (see Board::GetCastlingRights())
+        std::array<uint64_t, 8> EnPassant = {};                // Indexed by the file of the en passant square
+        uint64_t BlackToMove = 0;
+    };
+
+    // The keys are generated at compile time with SplitMix64, so they are the same on every build
+    inline constexpr Keys s_Keys = []() -> auto
+    {
+        Keys keys;
+
+        uint64_t state = 0x2545F4914F6CDD1D;
+        auto random = [&state]() {
+            uint64_t z = (state += 0x9E3779B97F4A7C15);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+            return z ^ (z >> 31);
+        };
+
+        for (auto& piece : keys.Pieces)
+            for (uint64_t& key : piece)
+                key = random();
+
+        // Each castling right gets a key, and a set of rights is the XOR of its keys
+        std::array<uint64_t, 4> castlingKeys = { random(), random(), random(), random() };
+        for (size_t rights = 0; rights < keys.Castling.size(); rights++)
+            for (size_t i = 0; i < castlingKeys.size(); i++)
+                if (rights & (1ull << i))
+                    keys.Castling[rights] ^= castlingKeys[i];
+
+        for (uint64_t& key : keys.EnPassant)
+            key = random();
+
+        keys.BlackToMove = random();
+
+        return keys;
+    }();
+
+    inline uint64_t PieceKey(Piece p, Square s) { return s_Keys.Pieces[p][s]; }
+
+    // The key of a piece for the pawn hash (only pawns count, so it's 0 for the other pieces)
+    inline uint64_t PawnKey(Piece p, Square s) { return GetPieceType(p) == Pawn ? s_Keys.Pieces[p][s] : 0; }
+
+    // Returns 0 if there is no en passant square
+    inline uint64_t EnPassantKey(Square s) { return s == 0 ? 0 : s_Keys.EnPassant[FileOf(s)]; }
+
+    // XOR with the old and new rights to get the key of the rights that changed
+    inline uint64_t CastlingKey(uint8_t rights) { return s_Keys.Castling[rights]; }
+
+    inline uint64_t PlayerTurnKey() { return s_Keys.BlackToMove; }
+
+}
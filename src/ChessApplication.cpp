@@ -5,6 +5,7 @@
 
 #include "Chess/Board.h"
 #include "ChessEngine/Engine.h"
+#include "ChessEngine/SearchEngine.h"
 #include "Graphics/Framebuffer.h"
 #include "Graphics/Renderer.h"
 #include "Graphics/SubTexture.h"
@@ -374,9 +375,23 @@ void ChessApplication::RenderImGui()
     if (s_ShowEngineWindow) {
         static auto s_SelectedEngine = m_Engines.end();
         static bool s_EnginesInitialized = false;
+        static std::string s_RunningEngineName;
 
         ImGui::Begin ("Engine", &s_ShowEngineWindow);
-        if (m_Engines.empty()) {
+
+        // The built-in engine needs no executable, so it can always be started
+        if (!s_EnginesInitialized && ImGui::Button ("Start built-in engine")) {
+            m_RunningEngine = std::make_unique<SearchEngine>();
+            m_RunningEngine->SetUpdateCallback ([this] (const Engine::BestContinuation & c) { OnEngineUpdate (c); });
+            m_RunningEngine->Init();
+            m_RunningEngine->SetPosition (m_BoardFEN);
+            m_RunningEngine->Run();
+
+            s_RunningEngineName = "Built-in engine";
+            s_EnginesInitialized = true;
+        }
+
+        if (!s_EnginesInitialized && m_Engines.empty()) {
             if (ImGui::Button ("Create engine")) {
                 // Place window into center
                 ImVec2 centre = ImGui::GetMainViewport()->GetCenter();
@@ -406,6 +421,7 @@ void ChessApplication::RenderImGui()
                         m_RunningEngine->Run();
 
                         s_SelectedEngine = it;
+                        s_RunningEngineName = name;
                         s_EnginesInitialized = true;
                     } catch (EngineCreationFailure &) {
                         ImGui::OpenPopup ("Failed to create engine");
@@ -431,12 +447,13 @@ void ChessApplication::RenderImGui()
                 std::rethrow_exception (m_RunningEngine->GetThreadException());
             }
 
-            ImGui::Text ("%s", s_SelectedEngine->first.c_str());
+            ImGui::Text ("%s", s_RunningEngineName.c_str());
 
             if (ImGui::Button ("Stop engine")) {
                 m_RunningEngine->Stop();  // Stop the engine
                 m_RunningEngine.reset();  // Stop the process
                 s_SelectedEngine = m_Engines.end();
+                s_EnginesInitialized = false;
             } else {
                 ImGui::Text ("Depth: %i", m_BestContinuation.Depth);
 
@@ -580,8 +597,8 @@ void ChessApplication::OnEngineUpdate (const Engine::BestContinuation &bestConti
     Board moveTranslator (m_Board);
 
     std::ostringstream continuationText;
-    for (LongAlgebraicMove m : m_BestContinuation.Continuation)
-        continuationText << moveTranslator.Move (m) << " ";
+    for (PackedMove m : m_BestContinuation.Continuation)
+        continuationText << moveTranslator.Move (m.ToLongAlgebraic()) << " ";
 
     m_BestContinuationAlgebraicMoves = continuationText.str();
 }
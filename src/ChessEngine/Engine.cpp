@@ -297,7 +297,7 @@ void Engine::HandleInfoCommand (StringParser &sp)
             while (sp.Next (move))
                 m_BestContinuation.Continuation.emplace_back (LongAlgebraicMove (move));
 
-            m_UpdateCallback (m_BestContinuation);
+            UpdateBestContinuation (m_BestContinuation);
 
             return;
         } else if (infoType == "cp") {
@@ -320,6 +320,14 @@ void Engine::HandleInfoCommand (StringParser &sp)
     // Ignore undefined commands
 }
 
+void Engine::UpdateBestContinuation (const BestContinuation &continuation)
+{
+    m_BestContinuation = continuation;
+
+    if (m_UpdateCallback)
+        m_UpdateCallback (m_BestContinuation);
+}
+
 void Engine::PrintInfo() const
 {
     std::cout << "Name: " << m_Name << "\n";
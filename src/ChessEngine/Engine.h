@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <filesystem>
 #include <functional>
 #include <optional>
@@ -26,9 +27,10 @@ public:
 
     virtual ~Engine();
 
-    bool Init();
-    void Run();  // Sends the "go" command
-    void Stop();
+    // Virtual so an engine that doesn't talk UCI over pipes (SearchEngine) can replace them
+    virtual bool Init();
+    virtual void Run();  // Sends the "go" command
+    virtual void Stop();
 
     bool IsRunning() const { return m_State == State::Running; }
 
@@ -43,8 +45,8 @@ public:
     void PrintInfo() const;
 
     struct BestContinuation {
-        std::vector<LongAlgebraicMove> Continuation;
-        LongAlgebraicMove PonderMove;
+        std::vector<PackedMove> Continuation;
+        PackedMove PonderMove = {};
         int32_t Depth = 0;
         int32_t Score = 0;  // Could be centipawns or mate
         bool Mate = false;  // If the score is mate or centipawns
@@ -52,30 +54,34 @@ public:
 
     const BestContinuation& GetBestContinuation() const { return m_BestContinuation; }
 
-    void SetPosition(const std::string& fen);
+    virtual void SetPosition(const std::string& fen);
 
     void SetUpdateCallback(const std::function<void(const BestContinuation&)>& callback) { m_UpdateCallback = callback; }
 
     std::exception_ptr GetThreadException() const { return m_ThreadException; }
 private:
-    std::string m_Name, m_Author;
     std::vector<Option*> m_Options;
     
     BestContinuation m_BestContinuation;
     std::function<void(const BestContinuation& continuation)> m_UpdateCallback;
 
     std::thread m_Thread;
-    std::exception_ptr m_ThreadException;
 protected:
     Engine() = default;
 
+    // Stores the new best continuation and passes it to the update callback
+    void UpdateBestContinuation(const BestContinuation& continuation);
+
+    std::string m_Name, m_Author;
+    std::exception_ptr m_ThreadException;
+
     enum class State {
         Uninitialized,
         Ready,
         Running
     };
 
-    State m_State = State::Uninitialized;
+    std::atomic<State> m_State = State::Uninitialized;  // Set by the engine's thread too
 private:
     virtual void Send(const std::string& message) = 0;
     virtual bool Receive(std::string& message) = 0;  // Returns false if no data received
@@ -0,0 +1,301 @@
+#include "Search.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+Search::Result Search::Run (const Board &board, const Limits &limits, const std::function<void (const Result &)> &onDepth)
+{
+    m_Board = board;
+    m_Nodes = 0;
+    m_NodeLimit = limits.Nodes;
+    m_PreviousPV.clear();
+
+    if (m_Table)
+        m_Table->NewSearch();
+
+    Result result;
+
+    for (int32_t depth = 1; depth <= std::min (limits.Depth, MaxDepth); depth++) {
+        m_FollowingPV = true;
+
+        const int32_t score = AlphaBeta (-MateScore, MateScore, depth, 0);
+        if (m_Stopped)
+            break;
+
+        result = MakeResult (score, depth);
+        m_PreviousPV = result.Continuation;
+
+        if (onDepth)
+            onDepth (result);
+
+        // There is nothing more to find once a forced mate is found (or there are no moves)
+        if (result.Mate || result.Continuation.empty())
+            break;
+    }
+
+    result.Nodes = m_Nodes;
+    return result;
+}
+
+int32_t Search::AlphaBeta (int32_t alpha, int32_t beta, int32_t depth, int32_t ply)
+{
+    m_PVLength[ply] = ply;
+
+    if (ply > 0 && (m_Board.IsRepetition (2) || m_Board.GetHalfMoves() >= 100 || m_Board.IsInsufficientMaterial()))
+        return 0;
+
+    const bool inCheck = m_Board.IsInCheck (m_Board.GetPlayerTurn());
+
+    // Looks one ply further when in check, so the search doesn't stop before seeing a way out
+    if (inCheck)
+        depth++;
+
+    if (depth <= 0 || ply >= MaxPly - 1)
+        return Quiescence (alpha, beta, ply);
+
+    if (ShouldStop())
+        return 0;
+
+    m_Nodes++;
+
+    // A result from the table is only used if it was searched at least as deep
+    // (never at the root, which needs the best line)
+    const uint64_t hash = m_Board.Hash();
+    PackedMove hashMove = {};
+    TranspositionTable::Entry entry;
+    if (m_Table && m_Table->Probe (hash, entry)) {
+        hashMove = entry.Move;
+
+        if (ply > 0 && entry.Depth >= depth) {
+            const int32_t score = ScoreFromTable (entry.Score, ply);
+
+            if (entry.ScoreBound == TranspositionTable::Bound::Exact)
+                return score;
+            if (entry.ScoreBound == TranspositionTable::Bound::Lower && score >= beta)
+                return beta;
+            if (entry.ScoreBound == TranspositionTable::Bound::Upper && score <= alpha)
+                return alpha;
+        }
+    }
+
+    MoveList moves;
+    size_t captures = 0;
+    if (inCheck) {
+        m_Board.GenerateEvasions (moves);
+    } else {
+        m_Board.GenerateCaptures (moves);
+        captures = moves.Size();
+        m_Board.GenerateQuietMoves (moves);
+    }
+
+    if (moves.Empty())
+        return inCheck ? -MateScore + ply : 0;
+
+    std::array<int32_t, MoveList::Capacity> scores;
+    OrderMoves (moves, captures, hashMove, ply, scores);
+
+    PackedMove bestMove = {};
+
+    for (size_t i = 0; i < moves.Size(); i++) {
+        // Selection sort, as a cut off usually comes before most of the moves are looked at
+        const size_t best = std::max_element (scores.begin() + i, scores.begin() + moves.Size()) - scores.begin();
+        std::swap (moves[i], moves[best]);
+        std::swap (scores[i], scores[best]);
+
+        const PackedMove m = moves[i];
+        const bool quiet = m_Board[m.DestinationSquare()] == Piece::None && m.Promotion() == Pawn;
+
+        UndoInfo undo;
+        m_Board.MakeMove (m, undo);
+        if (m_Table)
+            m_Table->Prefetch (m_Board.Hash());  // Loads while the child checks for draws and checks
+
+        const int32_t score = -AlphaBeta (-beta, -alpha, depth - 1, ply + 1);
+        m_Board.UnmakeMove (m, undo);
+
+        // Only the first move of a node on the last best line is on it
+        m_FollowingPV = false;
+
+        if (m_Stopped)
+            return 0;
+
+        if (score >= beta) {
+            if (quiet) {
+                if (m_Killers[ply][0] != m) {
+                    m_Killers[ply][1] = m_Killers[ply][0];
+                    m_Killers[ply][0] = m;
+                }
+
+                UpdateHistory (m, depth);
+            }
+
+            if (m_Table)
+                m_Table->Store (hash, m, ScoreToTable (beta, ply), 0, depth, TranspositionTable::Bound::Lower);
+
+            return beta;
+        }
+
+        if (score > alpha) {
+            alpha = score;
+            bestMove = m;
+
+            m_PV[ply][ply] = m;
+            for (int32_t next = ply + 1; next < m_PVLength[ply + 1]; next++)
+                m_PV[ply][next] = m_PV[ply + 1][next];
+            m_PVLength[ply] = m_PVLength[ply + 1];
+        }
+    }
+
+    if (m_Table) {
+        const TranspositionTable::Bound bound = bestMove != PackedMove{} ? TranspositionTable::Bound::Exact : TranspositionTable::Bound::Upper;
+        m_Table->Store (hash, bestMove, ScoreToTable (alpha, ply), 0, depth, bound);
+    }
+
+    return alpha;
+}
+
+int32_t Search::Quiescence (int32_t alpha, int32_t beta, int32_t ply)
+{
+    m_PVLength[ply] = ply;
+
+    if (ShouldStop())
+        return 0;
+
+    m_Nodes++;
+
+    if (ply >= MaxPly - 1)
+        return Evaluate (m_Board);
+
+    const bool inCheck = m_Board.IsInCheck (m_Board.GetPlayerTurn());
+
+    // Not capturing is an option too (the "stand pat"), unless in check
+    if (!inCheck) {
+        const int32_t standPat = Evaluate (m_Board);
+        if (standPat >= beta)
+            return standPat;
+        alpha = std::max (alpha, standPat);
+    }
+
+    MoveList moves;
+    if (inCheck)
+        m_Board.GenerateEvasions (moves);
+    else
+        m_Board.GenerateCaptures (moves);
+
+    if (inCheck && moves.Empty())
+        return -MateScore + ply;
+
+    for (PackedMove m : moves) {
+        // Captures that lose material can't raise the score above the stand pat
+        if (!inCheck && !m_Board.SEEGreaterOrEqual (m, 0))
+            continue;
+
+        UndoInfo undo;
+        m_Board.MakeMove (m, undo);
+        const int32_t score = -Quiescence (-beta, -alpha, ply + 1);
+        m_Board.UnmakeMove (m, undo);
+
+        if (m_Stopped)
+            return 0;
+
+        if (score >= beta)
+            return beta;
+
+        if (score > alpha) {
+            alpha = score;
+
+            m_PV[ply][ply] = m;
+            for (int32_t next = ply + 1; next < m_PVLength[ply + 1]; next++)
+                m_PV[ply][next] = m_PV[ply + 1][next];
+            m_PVLength[ply] = m_PVLength[ply + 1];
+        }
+    }
+
+    return alpha;
+}
+
+void Search::OrderMoves (MoveList &moves, size_t captures, PackedMove hashMove, int32_t ply, std::array<int32_t, MoveList::Capacity> &scores) const
+{
+    const PackedMove pvMove = m_FollowingPV && ply < (int32_t)m_PreviousPV.size() ? m_PreviousPV[ply] : PackedMove{};
+
+    for (size_t i = 0; i < moves.Size(); i++) {
+        const PackedMove m = moves[i];
+
+        if (m == pvMove)
+            scores[i] = 1 << 30;
+        else if (m == hashMove)
+            scores[i] = (1 << 30) - 1;
+        else if (i < captures)
+            scores[i] = (1 << 29) - (int32_t)i;  // GenerateCaptures() sorts them already
+        else if (m == m_Killers[ply][0])
+            scores[i] = (1 << 28) + 1;
+        else if (m == m_Killers[ply][1])
+            scores[i] = 1 << 28;
+        else
+            scores[i] = m_History[m.SourceSquare()][m.DestinationSquare()];
+    }
+}
+
+void Search::UpdateHistory (PackedMove m, int32_t depth)
+{
+    static_assert (HistoryLimit + MaxPly * MaxPly < (1 << 28), "History scores must stay below the killer moves");
+
+    int32_t &score = m_History[m.SourceSquare()][m.DestinationSquare()];
+    score += depth * depth;
+
+    if (score > HistoryLimit) {
+        for (std::array<int32_t, 64> &scores : m_History)
+            for (int32_t &s : scores)
+                s /= 2;
+    }
+}
+
+bool Search::ShouldStop()
+{
+    // Checking the flag on every node would slow the search down for nothing
+    if ((m_Nodes & 2047) == 0 && (m_Stop || (m_NodeLimit != 0 && m_Nodes >= m_NodeLimit)))
+        m_Stopped = true;
+
+    return m_Stopped;
+}
+
+Search::Result Search::MakeResult (int32_t score, int32_t depth) const
+{
+    Result result;
+    result.Depth = depth;
+    result.Continuation.assign (m_PV[0].begin(), m_PV[0].begin() + m_PVLength[0]);
+
+    // Mate scores count the plies from the root, so the moves to mate are half of them (rounded up)
+    if (std::abs (score) >= MateScore - MaxPly) {
+        const int32_t plies = MateScore - std::abs (score);
+        result.Mate = true;
+        result.Score = score > 0 ? (plies + 1) / 2 : -(plies / 2);
+    } else {
+        result.Score = score;
+    }
+
+    return result;
+}
+
+int32_t Search::ScoreToTable (int32_t score, int32_t ply)
+{
+    if (score >= MateScore - MaxPly)
+        return score + ply;
+    if (score <= -MateScore + MaxPly)
+        return score - ply;
+    return score;
+}
+
+int32_t Search::ScoreFromTable (int32_t score, int32_t ply)
+{
+    if (score >= MateScore - MaxPly)
+        return score - ply;
+    if (score <= -MateScore + MaxPly)
+        return score + ply;
+    return score;
+}
+
+int32_t Search::Evaluate (const Board &board)
+{
+    return board.StaticEval();
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "Chess/Board.h"
+#include "Chess/TranspositionTable.h"
+
+// An alpha-beta search on top of Board, so positions can be analysed without an external engine
+// Iterative deepening up to the depth limit (or until stopped), with a quiescence search of the captures at the leaves
+// https://www.chessprogramming.org/Alpha-Beta
+class Search
+{
+public:
+    static constexpr int32_t MaxDepth = 64;
+
+    struct Limits {
+        int32_t Depth = MaxDepth;
+        uint64_t Nodes = 0;  // No limit if 0
+    };
+
+    struct Result {
+        std::vector<PackedMove> Continuation;  // The best line, starting with the best move
+        int32_t Depth = 0;
+        int32_t Score = 0;   // In centipawns for the player to move, or the number of moves to mate if Mate is set
+        bool Mate = false;   // The score is negative if the player to move gets mated
+        uint64_t Nodes = 0;
+    };
+
+    // Returns the result of the last depth searched to the end (empty if stopped before depth 1 finished)
+    // 'onDepth' is called after each depth, from the thread running the search
+    Result Run (const Board &board, const Limits &limits, const std::function<void (const Result &)> &onDepth = {});
+
+    // Makes Run() return as soon as possible (can be called from another thread)
+    // A stopped search stays stopped, so a new search needs a new Search
+    void Stop() { m_Stop = true; }
+
+    // Uses 'table' to look up positions searched before (in this search or an earlier one), or none if null
+    // The table can be shared with other searches running at the same time
+    void SetTranspositionTable (TranspositionTable *table) { m_Table = table; }
+
+    // The evaluation at the leaves (Board::StaticEval(): material and piece placement) in centipawns for the player to move
+    static int32_t Evaluate (const Board &board);
+private:
+    int32_t AlphaBeta (int32_t alpha, int32_t beta, int32_t depth, int32_t ply);
+    int32_t Quiescence (int32_t alpha, int32_t beta, int32_t ply);
+
+    // Orders the moves of a node: the move of the last best line first, then the move from the table, the captures
+    // (already best first), the killer moves, and the rest by how often they caused a cut off
+    void OrderMoves (MoveList &moves, size_t captures, PackedMove hashMove, int32_t ply, std::array<int32_t, MoveList::Capacity> &scores) const;
+
+    void UpdateHistory (PackedMove m, int32_t depth);
+
+    bool ShouldStop();
+
+    Result MakeResult (int32_t score, int32_t depth) const;
+
+    // Mate scores in the table count the plies from the stored position instead of the root
+    static int32_t ScoreToTable (int32_t score, int32_t ply);
+    static int32_t ScoreFromTable (int32_t score, int32_t ply);
+private:
+    static constexpr int32_t MaxPly = 128;
+    static constexpr int32_t MateScore = 32000;  // Minus the plies to mate
+
+    Board m_Board;
+    TranspositionTable *m_Table = nullptr;
+    std::atomic<bool> m_Stop = false;
+    bool m_Stopped = false;  // Set once ShouldStop() sees the flag or the node limit, so the depth is thrown away
+
+    uint64_t m_Nodes = 0;
+    uint64_t m_NodeLimit = 0;
+
+    // The best line from each ply (triangular PV table)
+    std::array<std::array<PackedMove, MaxPly>, MaxPly> m_PV;
+    std::array<int32_t, MaxPly> m_PVLength = {};
+
+    // The best line of the last depth, searched first on the next one
+    std::vector<PackedMove> m_PreviousPV;
+    bool m_FollowingPV = false;
+
+    std::array<std::array<PackedMove, 2>, MaxPly> m_Killers = {};    // Quiet moves that caused a cut off at each ply
+    std::array<std::array<int32_t, 64>, 64> m_History = {};          // By source and destination square
+
+    // When a history score passes this, the whole table is halved, so the scores can't overflow and stay below
+    // the killer moves, and the cut offs of the last few depths count more than older ones
+    static constexpr int32_t HistoryLimit = 1 << 16;
+};
@@ -0,0 +1,81 @@
+#include "SearchEngine.h"
+
+SearchEngine::SearchEngine (const Search::Limits &limits, size_t hashMegabytes)
+    : m_Limits (limits)
+{
+    m_Name = "Built-in search";
+
+    if (hashMegabytes != 0)
+        m_Table = std::make_unique<TranspositionTable> (hashMegabytes);
+}
+
+SearchEngine::~SearchEngine()
+{
+    // Engine::~Engine() would try to stop a UCI engine
+    Stop();
+}
+
+bool SearchEngine::Init()
+{
+    m_State = State::Ready;
+    return true;
+}
+
+void SearchEngine::Run()
+{
+    if (m_State != State::Ready) {
+        throw EngineNotReady();
+    }
+
+    // A search that finished on its own left its thread to be joined
+    if (m_SearchThread.joinable())
+        m_SearchThread.join();
+
+    m_State = State::Running;
+
+    m_Search = std::make_unique<Search>();
+    m_Search->SetTranspositionTable (m_Table.get());
+    m_SearchThread = std::thread (&SearchEngine::RunSearch, this);
+}
+
+void SearchEngine::Stop()
+{
+    // The search may have finished on its own (and set the state back to Ready), but its thread still needs joining
+    if (m_SearchThread.joinable()) {
+        m_Search->Stop();
+        m_SearchThread.join();
+        m_State = State::Ready;
+    }
+}
+
+void SearchEngine::SetPosition (const std::string &fen)
+{
+    if (m_State == State::Running) {
+        Stop();
+        m_Board.FromFEN (fen);
+        Run();
+    } else {
+        m_Board.FromFEN (fen);
+    }
+}
+
+void SearchEngine::RunSearch()
+{
+    try {
+        m_Search->Run (m_Board, m_Limits, [this] (const Search::Result & result) {
+            BestContinuation continuation;
+            continuation.Continuation = result.Continuation;
+            continuation.PonderMove = result.Continuation.size() > 1 ? result.Continuation[1] : PackedMove{};
+            continuation.Depth = result.Depth;
+            continuation.Score = result.Score;
+            continuation.Mate = result.Mate;
+
+            UpdateBestContinuation (continuation);
+        });
+    } catch (std::exception &) {
+        m_ThreadException = std::current_exception();
+    }
+
+    // Finished (or stopped), so the engine is idle again, like after Stop()
+    m_State = State::Ready;
+}
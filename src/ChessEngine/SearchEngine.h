@@ -0,0 +1,40 @@
+#pragma once
+
+#include <memory>
+#include <thread>
+
+#include "Engine.h"
+#include "Search.h"
+
+#include "Chess/Board.h"
+#include "Chess/TranspositionTable.h"
+
+// An engine that searches in this process (with Search) instead of talking UCI to another program
+// There is no process to start or protocol to parse, so it's quick to start and works without an external engine
+// The search runs on its own thread until it reaches the depth limit or Stop() is called
+class SearchEngine : public Engine
+{
+public:
+    // The search uses a transposition table of 'hashMegabytes' (none if 0), kept between searches
+    explicit SearchEngine (const Search::Limits &limits = {}, size_t hashMegabytes = 16);
+    ~SearchEngine() override;
+
+    bool Init() override;  // Nothing to start, so the engine is ready straight away
+    void Run() override;
+    void Stop() override;
+
+    void SetPosition (const std::string &fen) override;
+private:
+    // There is no other process to talk to
+    void Send (const std::string &) override {}
+    bool Receive (std::string &) override { return false; }
+
+    void RunSearch();
+private:
+    Board m_Board;
+    Search::Limits m_Limits;
+    std::unique_ptr<TranspositionTable> m_Table;
+
+    std::unique_ptr<Search> m_Search;  // A new one for every Run(), as a stopped Search stays stopped
+    std::thread m_SearchThread;
+};
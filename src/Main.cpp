@@ -31,7 +31,11 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
 
 #include <iostream>
 
+#include "Chess/PseudoLegal.h"
+
 int main() {
+    std::cout << "Slider attacks: " << PseudoLegal::SliderAttackName() << "\n";
+
     auto app = new ChessApplication(1280, 720, "Chess");
     try {
         app->Run();
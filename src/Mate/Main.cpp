@@ -0,0 +1,99 @@
+#include "Mate.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// Usage:
+//   chess-mate [-t <threads>] <moves> [fen]  Looks for a mate in <moves> moves or fewer (start position by default)
+// Prints the mating line in algebraic notation, and exits with 0 if there is a mate, 1 if there isn't, and 2 on errors
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    constexpr size_t HashMegabytes = 64;
+
+    int PrintUsage() {
+        std::cout << "Usage:\n"
+            "  chess-mate [-t <threads>] <moves> [fen]  Look for a mate in <moves> moves or fewer\n"
+            "                                           (one thread per core by default)\n";
+        return 2;
+    }
+
+    // The moves with their numbers, ex. "1. Qh5+ Kd7 2. Qf7#" or "1... Qh4#"
+    std::string FormatLine(Board board, const std::vector<PackedMove>& line) {
+        std::string result;
+
+        for (size_t i = 0; i < line.size(); i++) {
+            if (board.GetPlayerTurn() == White)
+                result += std::to_string(board.GetFullMoves()) + ". ";
+            else if (i == 0)
+                result += std::to_string(board.GetFullMoves()) + "... ";
+
+            result += board.ToAlgebraic(line[i]).ToString() + " ";
+            board.Apply(line[i]);
+        }
+
+        if (!result.empty())
+            result.pop_back();
+
+        return result;
+    }
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    try {
+        size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+        int arg = 1;
+        if (arg + 1 < argc && std::strcmp(argv[arg], "-t") == 0) {
+            const int count = std::stoi(argv[arg + 1]);
+            if (count < 1)
+                return PrintUsage();
+
+            threads = count;
+            arg += 2;
+        }
+
+        if (arg >= argc)
+            return PrintUsage();
+
+        const int32_t moves = std::stoi(argv[arg++]);
+        if (moves < 1)
+            return PrintUsage();
+
+        // The FEN may be given as one argument or as several
+        std::string fen;
+        for (int i = arg; i < argc; i++)
+            fen += std::string(i > arg ? " " : "") + argv[i];
+
+        Board board;
+        if (!fen.empty())
+            board.FromFEN(fen);
+
+        TranspositionTable table(HashMegabytes);
+
+        const Clock::time_point start = Clock::now();
+        const Mate::Result result = Mate::Solve(board, moves, threads, table);
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        if (result.Moves > 0)
+            std::cout << "Mate in " << result.Moves << ": " << FormatLine(board, result.Line) << "\n";
+        else
+            std::cout << "No mate in " << moves << "\n";
+
+        std::cout << result.Nodes << " nodes in " << std::fixed << std::setprecision(3) << seconds << " s ("
+            << threads << (threads == 1 ? " thread)\n" : " threads)\n");
+
+        return result.Moves > 0 ? 0 : 1;
+    } catch (std::exception& e) {
+        std::cout << "Error: " << e.what() << "\n";
+        return 2;
+    }
+}
@@ -0,0 +1,297 @@
+#include "Mate.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+    // The search of one thread, on its own copy of the board
+    // "Attack" is the side that mates, and "moves" always counts the attacker's moves
+    class Prover {
+    public:
+        Prover(const Board& board, TranspositionTable& table)
+            : m_Board(board), m_Table(table) {}
+
+        // Makes the search give up (returning false) while 'rootIndex' is above 'best'
+        // A thread searching a root move after one already proven to mate has nothing to add
+        void SetRootMove(const std::atomic<size_t>* best, size_t rootIndex) {
+            m_Best = best;
+            m_RootIndex = rootIndex;
+        }
+
+        // Whether the side to move can mate in 'moves' moves or fewer
+        // 'mate' is set to the first move of the mate if it isn't null
+        bool Attack(int32_t moves, PackedMove* mate) {
+            m_Nodes++;
+
+            if (Aborted())
+                return false;
+
+            // A mate within fewer moves is a mate within more, and no mate within more moves means none within fewer
+            const uint64_t hash = m_Board.Hash();
+            TranspositionTable::Entry entry;
+            if (m_Table.Probe(hash, entry)) {
+                if (entry.ScoreBound == TranspositionTable::Bound::Lower && entry.Depth <= moves) {
+                    if (mate)
+                        *mate = entry.Move;
+                    return true;
+                }
+
+                if (entry.ScoreBound == TranspositionTable::Bound::Upper && entry.Depth >= moves)
+                    return false;
+            }
+
+            // The last move has to be a check, so only checks are needed then
+            MoveList attacks;
+            if (OrderAttacks(attacks, moves == 1)) {
+                m_Table.Store(hash, attacks[0], 0, 0, 1, TranspositionTable::Bound::Lower);
+                if (mate)
+                    *mate = attacks[0];
+                return true;
+            }
+
+            if (moves > 1) {
+                for (PackedMove m : attacks) {
+                    UndoInfo undo;
+                    m_Board.MakeMove(m, undo);
+                    const bool mates = Defend(moves - 1);
+                    m_Board.UnmakeMove(m, undo);
+
+                    if (Aborted())
+                        return false;
+
+                    if (mates) {
+                        m_Table.Store(hash, m, 0, 0, moves, TranspositionTable::Bound::Lower);
+                        if (mate)
+                            *mate = m;
+                        return true;
+                    }
+                }
+            }
+
+            m_Table.Store(hash, {}, 0, 0, moves, TranspositionTable::Bound::Upper);
+            return false;
+        }
+
+        // Whether the side to move is mated, or is mated within 'moves' moves of the attacker whatever it plays
+        bool Defend(int32_t moves) {
+            m_Nodes++;
+
+            // Captures first, as taking the attacking piece is the likeliest way out
+            MoveList defences;
+            if (m_Board.IsInCheck(m_Board.GetPlayerTurn())) {
+                m_Board.GenerateEvasions(defences);
+
+                if (defences.Empty())
+                    return true;
+            } else {
+                m_Board.GenerateCaptures(defences);
+                m_Board.GenerateQuietMoves(defences);
+
+                if (defences.Empty())
+                    return false;  // Stalemate
+            }
+
+            if (moves <= 0)
+                return false;
+
+            for (PackedMove m : defences) {
+                UndoInfo undo;
+                m_Board.MakeMove(m, undo);
+                const bool mated = Attack(moves, nullptr);
+                m_Board.UnmakeMove(m, undo);
+
+                if (!mated)
+                    return false;
+            }
+
+            return true;
+        }
+
+        // Fills 'attacks' with the legal moves, with the checks first, the ones leaving the fewest replies first
+        // A check with no replies is mate, so it comes first, and true is returned
+        // Mates are mostly found among checks, and finding whether a move is one means making it,
+        // which is cheap next to searching a move that turns out not to be needed
+        bool OrderAttacks(MoveList& attacks, bool checksOnly) {
+            MoveList moves;
+            if (m_Board.IsInCheck(m_Board.GetPlayerTurn())) {
+                m_Board.GenerateEvasions(moves);
+            } else {
+                m_Board.GenerateCaptures(moves);
+                m_Board.GenerateQuietMoves(moves);
+            }
+
+            const Colour defender = OppositeColour(m_Board.GetPlayerTurn());
+
+            std::array<size_t, MoveList::Capacity> replies;
+            size_t checks = 0;
+            MoveList others;
+
+            for (PackedMove m : moves) {
+                UndoInfo undo;
+                m_Board.MakeMove(m, undo);
+
+                if (m_Board.IsInCheck(defender)) {
+                    replies[checks] = m_Board.CountLegalMoves();
+                    attacks.Add(m);
+                    checks++;
+                } else if (!checksOnly) {
+                    others.Add(m);
+                }
+
+                m_Board.UnmakeMove(m, undo);
+            }
+
+            // Insertion sort keeps the checks with the same number of replies in generation order
+            for (size_t i = 1; i < checks; i++) {
+                for (size_t j = i; j > 0 && replies[j] < replies[j - 1]; j--) {
+                    std::swap(replies[j], replies[j - 1]);
+                    std::swap(attacks[j], attacks[j - 1]);
+                }
+            }
+
+            for (PackedMove m : others)
+                attacks.Add(m);
+
+            return checks > 0 && replies[0] == 0;
+        }
+
+        inline Board& GetBoard() { return m_Board; }
+        inline uint64_t Nodes() const { return m_Nodes; }
+
+        inline bool Aborted() const {
+            return m_Best && m_RootIndex > m_Best->load(std::memory_order_relaxed);
+        }
+    private:
+        Board m_Board;
+        TranspositionTable& m_Table;
+
+        const std::atomic<size_t>* m_Best = nullptr;
+        size_t m_RootIndex = 0;
+
+        uint64_t m_Nodes = 0;
+    };
+
+    // Plays out the mate in 'moves' moves starting with 'first', with the longest defence at each move
+    // Everything on the line was proven by the search, so most of it is found in the table
+    std::vector<PackedMove> MatingLine(const Board& board, PackedMove first, int32_t moves, TranspositionTable& table, uint64_t& nodes) {
+        Prover prover(board, table);
+        Board& position = prover.GetBoard();
+
+        std::vector<PackedMove> line;
+        PackedMove attack = first;
+
+        while (true) {
+            UndoInfo undo;
+            position.MakeMove(attack, undo);
+            line.push_back(attack);
+            moves--;
+
+            MoveList defences;
+            position.GenerateLegalMoves(defences);
+            if (defences.Empty() || moves <= 0)
+                break;
+
+            // The defence that puts the mate off the longest, and the attacker's answer to it
+            PackedMove defence = {};
+            int32_t longest = 0;
+
+            for (PackedMove m : defences) {
+                position.MakeMove(m, undo);
+
+                for (int32_t left = 1; left <= moves; left++) {
+                    PackedMove mate;
+                    if (prover.Attack(left, &mate)) {
+                        if (left > longest) {
+                            longest = left;
+                            defence = m;
+                            attack = mate;
+                        }
+                        break;
+                    }
+                }
+
+                position.UnmakeMove(m, undo);
+            }
+
+            // Every defence was refuted by the proof, so a mate must be found after one of them
+            if (longest == 0)
+                throw std::logic_error("No mate found after any defence on the mating line");
+
+            position.MakeMove(defence, undo);
+            line.push_back(defence);
+            moves = longest;
+        }
+
+        nodes += prover.Nodes();
+        return line;
+    }
+
+}
+
+namespace Mate {
+
+    Result Solve(const Board& board, int32_t moves, size_t threads, TranspositionTable& table) {
+        threads = std::max<size_t>(threads, 1);
+        table.NewSearch();
+
+        Result result;
+
+        for (int32_t depth = 1; depth <= moves; depth++) {
+            Prover root(board, table);
+
+            MoveList attacks;
+            const bool mateInOne = root.OrderAttacks(attacks, depth == 1);
+            result.Nodes++;
+
+            // The index of the first root move proven to mate, and of the next one to search
+            std::atomic<size_t> best = mateInOne ? 0 : std::numeric_limits<size_t>::max();
+            std::atomic<size_t> next = 0;
+            std::atomic<uint64_t> nodes = 0;
+
+            auto work = [&]() {
+                Prover prover(board, table);
+
+                for (size_t i = next++; i < attacks.Size() && i < best; i = next++) {
+                    prover.SetRootMove(&best, i);
+
+                    UndoInfo undo;
+                    prover.GetBoard().MakeMove(attacks[i], undo);
+                    const bool mates = prover.Defend(depth - 1);
+                    prover.GetBoard().UnmakeMove(attacks[i], undo);
+
+                    // Only an earlier move can replace the best one (a proof is never cut short by aborting, only a refutation)
+                    size_t current = best;
+                    while (mates && i < current && !best.compare_exchange_weak(current, i)) {}
+                }
+
+                nodes += prover.Nodes();
+            };
+
+            if (!mateInOne && depth > 1) {
+                // This thread searches too, as one of the 'threads'
+                std::vector<std::thread> workers;
+                for (size_t i = 1; i < threads; i++)
+                    workers.emplace_back(work);
+                work();
+
+                for (std::thread& worker : workers)
+                    worker.join();
+            }
+
+            result.Nodes += nodes;
+
+            if (best < attacks.Size()) {
+                result.Moves = depth;
+                result.Line = MatingLine(board, attacks[best], depth, table, result.Nodes);
+                break;
+            }
+        }
+
+        return result;
+    }
+
+}
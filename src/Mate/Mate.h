@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vector>
+
+#include "Chess/Board.h"
+#include "Chess/TranspositionTable.h"
+
+// A mate solver: proves that the side to move can force mate within N moves, or that it can't
+// There is no evaluation, as a position either is a forced mate or isn't, so every answer is exact,
+// and the search stops as soon as one mating move is proven (every defence has to be searched though)
+// The 50 move rule and repetitions are ignored, like in problem solving
+// https://www.chessprogramming.org/Mate_Search
+
+namespace Mate {
+
+    struct Result {
+        int32_t Moves = 0;             // The moves of the side to move until mate (the fewest), or 0 if there is no mate
+        std::vector<PackedMove> Line;  // The mating moves, each answered by the defence that holds out the longest
+        uint64_t Nodes = 0;
+    };
+
+    // Looks for a mate in 1, 2, ... up to 'moves' moves for the side to move, and stops at the first one found
+    // The root moves are shared out between 'threads' threads, which share 'table' (it can be reused for another solve)
+    // The line starts with the first mating move in the move ordering, whichever thread proves it, so the first
+    // move is the same for any number of threads; the rest of the line can differ with what is in the table
+    Result Solve(const Board& board, int32_t moves, size_t threads, TranspositionTable& table);
+
+}
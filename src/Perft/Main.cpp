@@ -0,0 +1,437 @@
+#include "Perft.h"
+
+#include "Chess/ChessException.h"
+#include "Chess/PawnStructure.h"
+#include "Chess/PseudoLegal.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Usage:
+//   chess-perft                      Runs the test suite and checks every node count (and that Board::Apply() rejects illegal moves)
+//   chess-perft pseudo               Same, but with pseudo-legal generation and Board::IsLegal()
+//   chess-perft perft <depth> [fen]  Counts the nodes of one position (start position by default)
+//   chess-perft divide <depth> [fen] Same as perft, but also prints the nodes below each move
+//   chess-perft threads <depth> [fen] Counts the nodes with 1 up to one thread per core, sharing a hash table
+//   chess-perft sliders              Compares the speed of the slider attack implementations
+//   chess-perft replay               Compares replaying games with and without algebraic notation
+//   chess-perft pawns                Compares analysing the pawns of every position with and without the pawn cache
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    // The benchmarks store their results here so that the work behind them can't be optimised away
+    volatile uint64_t s_Sink = 0;
+
+    double SecondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    void PrintSpeed(uint64_t nodes, double seconds) {
+        std::cout << nodes << " nodes in " << std::fixed << std::setprecision(3) << seconds << " s ("
+            << std::setprecision(0) << (seconds > 0.0 ? nodes / seconds : 0.0) << " nodes/second)";
+        std::cout.unsetf(std::ios::fixed);
+    }
+
+    int RunTestSuite(uint64_t (*count)(Board&, int32_t)) {
+        uint64_t totalNodes = 0;
+        double totalSeconds = 0.0;
+        size_t failures = 0;
+
+        for (const Perft::TestPosition& position : Perft::TestSuite) {
+            Board board{ std::string(position.FEN) };
+
+            Clock::time_point start = Clock::now();
+            uint64_t nodes = count(board, position.Depth);
+            double seconds = SecondsSince(start);
+
+            totalNodes += nodes;
+            totalSeconds += seconds;
+
+            const bool passed = nodes == position.Nodes;
+            failures += !passed;
+
+            std::cout << (passed ? "[ OK ] " : "[FAIL] ") << position.Name << " (depth " << position.Depth << "): ";
+            PrintSpeed(nodes, seconds);
+            if (!passed)
+                std::cout << ", expected " << position.Nodes << "\n    " << position.FEN;
+            std::cout << "\n";
+        }
+
+        std::cout << "\nTotal: ";
+        PrintSpeed(totalNodes, totalSeconds);
+        std::cout << "\n" << failures << " of " << std::size(Perft::TestSuite) << " positions failed\n";
+
+        return failures == 0 ? 0 : 1;
+    }
+
+    // Board::Apply() has to throw on an illegal move, and leave the board as it was
+    int RunApplyTests() {
+        struct ApplyTest {
+            std::string_view Name;
+            std::string_view FEN;
+            PackedMove Move;
+        };
+
+        const ApplyTest tests[] = {
+            { "Queen to the last rank with a promotion", "k7/8/8/8/8/8/8/3QK3 w - - 0 1",  PackedMove(D1, D8, Queen) },
+            { "Same, but illegal (in check)",            "k7/8/8/8/8/8/8/3QK2r w - - 0 1", PackedMove(D1, D8, Queen) },
+            { "Double push with a promotion",            "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", PackedMove(E2, E4, Queen) },
+            { "Moving into check",                       "k7/8/8/8/8/8/7r/4K3 w - - 0 1",  PackedMove(E1, E2) },
+        };
+
+        size_t failures = 0;
+
+        for (const ApplyTest& test : tests) {
+            Board board{ std::string(test.FEN) };
+            const uint64_t hash = board.Hash();
+
+            bool threw = false;
+            try {
+                board.Apply(test.Move);
+            } catch (IllegalMoveException&) {
+                threw = true;
+            }
+
+            const bool passed = threw && board.ToFEN() == test.FEN && board.Hash() == hash;
+            failures += !passed;
+
+            std::cout << (passed ? "[ OK ] " : "[FAIL] ") << "Apply(): " << test.Name << " (" << test.Move << ")";
+            if (!passed)
+                std::cout << (threw ? ", the board changed: " + board.ToFEN() : ", no exception");
+            std::cout << "\n";
+        }
+
+        std::cout << failures << " of " << std::size(tests) << " illegal moves were not rejected\n\n";
+
+        return failures == 0 ? 0 : 1;
+    }
+
+    int RunPerft(Board& board, int32_t depth, bool divide) {
+        Clock::time_point start = Clock::now();
+        uint64_t nodes = 0;
+
+        if (divide) {
+            for (auto& [move, count] : Perft::Divide(board, depth)) {
+                std::cout << move << ": " << count << "\n";
+                nodes += count;
+            }
+            std::cout << "\n";
+        } else {
+            nodes = Perft::Count(board, depth);
+        }
+
+        double seconds = SecondsSince(start);
+
+        std::cout << "Depth " << depth << ": ";
+        PrintSpeed(nodes, seconds);
+        std::cout << "\n";
+
+        return 0;
+    }
+
+    int RunThreadScaling(const Board& board, int32_t depth) {
+        const size_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+        constexpr size_t hashMegabytes = 64;
+
+        Perft::HashTable table(hashMegabytes);
+
+        uint64_t expectedNodes = 0;
+        double singleThreadSpeed = 0.0;
+
+        for (size_t threads = 1; threads <= maxThreads; threads++) {
+            // Each run starts with an empty table, so they all do the same work
+            table.Clear();
+
+            Clock::time_point start = Clock::now();
+            Perft::ParallelResult result = Perft::CountParallel(board, depth, threads, &table);
+            double seconds = SecondsSince(start);
+
+            const double speed = seconds > 0.0 ? result.Nodes / seconds : 0.0;
+            if (threads == 1) {
+                expectedNodes = result.Nodes;
+                singleThreadSpeed = speed;
+            }
+
+            // Perfect scaling is N times the speed of one thread
+            std::cout << threads << (threads == 1 ? " thread:  " : " threads: ");
+            PrintSpeed(result.Nodes, seconds);
+            std::cout << ", efficiency " << std::fixed << std::setprecision(0)
+                << (singleThreadSpeed > 0.0 ? 100.0 * speed / (singleThreadSpeed * threads) : 0.0) << "%\n";
+
+            for (size_t i = 0; i < result.Threads.size(); i++) {
+                const Perft::ThreadResult& thread = result.Threads[i];
+                std::cout << "    thread " << i << ": " << std::setprecision(0)
+                    << (thread.Seconds > 0.0 ? thread.Nodes / thread.Seconds : 0.0) << " nodes/second\n";
+            }
+            std::cout.unsetf(std::ios::fixed);
+
+            if (result.Nodes != expectedNodes) {
+                std::cout << "Node count differs from 1 thread (" << expectedNodes << ")\n";
+                return 1;
+            }
+        }
+
+        return 0;
+    }
+
+    // Times 'lookup' over a fixed set of random squares and blockers
+    template <typename Lookup>
+    void BenchmarkSlider(const char* name, Lookup lookup) {
+        // Small enough that the samples stay in the cache (the lookup tables may not)
+        static std::array<std::pair<Square, BitBoard>, 4096> s_Samples = []() {
+            std::array<std::pair<Square, BitBoard>, 4096> samples;
+
+            uint64_t state = 0x9E3779B97F4A7C15;
+            for (auto& [square, blockers] : samples) {
+                // xorshift64
+                state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+                square = state & 63;
+                blockers = state & (state >> 17);  // Around a quarter of the squares are occupied
+            }
+
+            return samples;
+        }();
+
+        constexpr size_t iterations = 4000;
+
+        BitBoard result = 0;
+        Clock::time_point start = Clock::now();
+        for (size_t i = 0; i < iterations; i++)
+            for (auto& [square, blockers] : s_Samples)
+                result ^= lookup(square, blockers);
+        double seconds = SecondsSince(start);
+
+        s_Sink = result;
+
+        const double lookups = (double)iterations * s_Samples.size();
+        std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(2)
+            << seconds * 1e9 / lookups << " ns/lookup\n";
+        std::cout.unsetf(std::ios::fixed);
+    }
+
+    int RunSliderBenchmark() {
+        BenchmarkSlider("Kindergarten bishop", PseudoLegal::Kindergarten::BishopAttack);
+        BenchmarkSlider("Magic bishop", PseudoLegal::Magic::BishopAttack);
+        BenchmarkSlider("Kindergarten rook", PseudoLegal::Kindergarten::RookAttack);
+        BenchmarkSlider("Magic rook", PseudoLegal::Magic::RookAttack);
+        BenchmarkSlider("Kindergarten queen", [](Square s, BitBoard b) { return PseudoLegal::Kindergarten::BishopAttack(s, b) | PseudoLegal::Kindergarten::RookAttack(s, b); });
+        BenchmarkSlider("Magic queen", [](Square s, BitBoard b) { return PseudoLegal::Magic::BishopAttack(s, b) | PseudoLegal::Magic::RookAttack(s, b); });
+
+#if defined(CHESS_PEXT_BITBOARDS)
+        if (PseudoLegal::Pext::IsSupported()) {
+            BenchmarkSlider("PEXT bishop", PseudoLegal::Pext::BishopAttack);
+            BenchmarkSlider("PEXT rook", PseudoLegal::Pext::RookAttack);
+            BenchmarkSlider("PEXT queen", [](Square s, BitBoard b) { return PseudoLegal::Pext::BishopAttack(s, b) | PseudoLegal::Pext::RookAttack(s, b); });
+        } else {
+            std::cout << "PEXT is not supported on this CPU\n";
+        }
+#endif
+
+        std::cout << "\n";
+
+        // The attacks of a whole side, one lookup per slider against all sliders at once
+        // A few of the blockers (around 3) are picked as the bishops and rooks
+        constexpr BitBoard bishopSquares = 0x0024000000002400;
+        constexpr BitBoard rookSquares = 0x8100000810000081;
+
+        BenchmarkSlider("Lookup per slider", [](Square, BitBoard b) {
+            BitBoard attacks = 0;
+            for (Square s : Squares(b & bishopSquares))
+                attacks |= PseudoLegal::BishopAttack(s, b);
+            for (Square s : Squares(b & rookSquares))
+                attacks |= PseudoLegal::RookAttack(s, b);
+            return attacks;
+        });
+        BenchmarkSlider("Kogge-Stone", [](Square, BitBoard b) { return PseudoLegal::KoggeStone::SliderAttacks(b & bishopSquares, b & rookSquares, b); });
+
+#if defined(CHESS_AVX2_ATTACKS)
+        if (PseudoLegal::Avx2::IsSupported())
+            BenchmarkSlider("Kogge-Stone AVX2", [](Square, BitBoard b) { return PseudoLegal::Avx2::SliderAttacks(b & bishopSquares, b & rookSquares, b); });
+        else
+            std::cout << "AVX2 is not supported on this CPU\n";
+#endif
+
+        return 0;
+    }
+
+    // Plays random games from the start position (the same ones on every run)
+    std::vector<std::vector<PackedMove>> GenerateGames(size_t count, size_t maxPlies) {
+        std::vector<std::vector<PackedMove>> games(count);
+
+        uint64_t state = 0x9E3779B97F4A7C15;
+        for (std::vector<PackedMove>& game : games) {
+            Board board;
+            MoveList moves;
+
+            while (game.size() < maxPlies && board.Status() == GameStatus::Ongoing) {
+                moves.Clear();
+                board.GenerateLegalMoves(moves);
+
+                // xorshift64
+                state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+                const PackedMove m = moves[state % moves.Size()];
+
+                UndoInfo undo;
+                board.MakeMove(m, undo);
+                game.push_back(m);
+            }
+        }
+
+        return games;
+    }
+
+    int RunReplayBenchmark() {
+        const std::vector<std::vector<PackedMove>> games = GenerateGames(1000, 200);
+
+        size_t plies = 0;
+        for (const std::vector<PackedMove>& game : games)
+            plies += game.size();
+
+        std::cout << games.size() << " games, " << plies << " moves\n";
+
+        uint64_t result = 0;
+        auto printTime = [plies](const char* name, double seconds) {
+            std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(1)
+                << seconds * 1e9 / plies << " ns/move\n";
+            std::cout.unsetf(std::ios::fixed);
+        };
+
+        Clock::time_point start = Clock::now();
+        for (const std::vector<PackedMove>& game : games) {
+            Board board;
+            for (PackedMove m : game)
+                result += board.Move(m.ToLongAlgebraic()).Flags;
+        }
+        printTime("Board::Move()", SecondsSince(start));
+
+        start = Clock::now();
+        for (const std::vector<PackedMove>& game : games) {
+            Board board;
+            for (PackedMove m : game)
+                board.Apply(m);
+            result += board.Hash();
+        }
+        printTime("Board::Apply()", SecondsSince(start));
+
+        s_Sink = result;
+
+        return 0;
+    }
+
+    int RunPawnBenchmark() {
+        const std::vector<std::vector<PackedMove>> games = GenerateGames(1000, 200);
+
+        size_t plies = 0;
+        for (const std::vector<PackedMove>& game : games)
+            plies += game.size();
+
+        std::cout << games.size() << " games, " << plies << " positions\n";
+
+        uint64_t result = 0;
+        auto printTime = [plies](const char* name, double seconds) {
+            std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(1)
+                << seconds * 1e9 / plies << " ns/position\n";
+            std::cout.unsetf(std::ios::fixed);
+        };
+
+        // Both include replaying the games, which is the same for each
+        Clock::time_point start = Clock::now();
+        for (const std::vector<PackedMove>& game : games) {
+            Board board;
+            for (PackedMove m : game) {
+                board.Apply(m);
+                result += PawnStructure::Analyse(board.Pieces(Pawn, White), board.Pieces(Pawn, Black)).Backward[White];
+            }
+        }
+        printTime("Analyse()", SecondsSince(start));
+
+        PawnStructure::Cache cache;
+        start = Clock::now();
+        for (const std::vector<PackedMove>& game : games) {
+            Board board;
+            for (PackedMove m : game) {
+                board.Apply(m);
+                result += cache.Probe(board).Backward[White];
+            }
+        }
+        printTime("Cache::Probe()", SecondsSince(start));
+
+        std::cout << "Hits: " << cache.Hits() << " (" << std::fixed << std::setprecision(1)
+            << 100.0 * cache.Hits() / (cache.Hits() + cache.Misses()) << "%)\n";
+        std::cout.unsetf(std::ios::fixed);
+
+        s_Sink = result;
+
+        return 0;
+    }
+
+    int PrintUsage() {
+        std::cout << "Usage:\n"
+            "  chess-perft                       Run the test suite\n"
+            "  chess-perft pseudo                Run the test suite with pseudo-legal move generation\n"
+            "  chess-perft perft <depth> [fen]   Count the nodes of a position\n"
+            "  chess-perft divide <depth> [fen]  Count the nodes below each move\n"
+            "  chess-perft threads <depth> [fen] Count the nodes with 1 to N threads and a shared hash table\n"
+            "  chess-perft sliders               Compare the slider attack implementations\n"
+            "  chess-perft replay                Compare replaying games with and without notation\n"
+            "  chess-perft pawns                 Compare analysing pawn structures with and without the cache\n";
+        return 1;
+    }
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    std::cout << "Slider attacks: " << PseudoLegal::SliderAttackName() << "\n\n";
+
+    if (argc < 2) {
+        const int applyResult = RunApplyTests();
+        return RunTestSuite(Perft::Count) | applyResult;
+    }
+
+    if (std::strcmp(argv[1], "pseudo") == 0)
+        return RunTestSuite(Perft::CountPseudoLegal);
+
+    if (std::strcmp(argv[1], "sliders") == 0)
+        return RunSliderBenchmark();
+
+    if (std::strcmp(argv[1], "replay") == 0)
+        return RunReplayBenchmark();
+
+    if (std::strcmp(argv[1], "pawns") == 0)
+        return RunPawnBenchmark();
+
+    const bool divide = std::strcmp(argv[1], "divide") == 0;
+    const bool threads = std::strcmp(argv[1], "threads") == 0;
+    if ((!divide && !threads && std::strcmp(argv[1], "perft") != 0) || argc < 3)
+        return PrintUsage();
+
+    try {
+        int32_t depth = std::stoi(argv[2]);
+
+        // The FEN may be given as one argument or as several
+        std::string fen;
+        for (int i = 3; i < argc; i++)
+            fen += std::string(i > 3 ? " " : "") + argv[i];
+
+        Board board;
+        if (!fen.empty())
+            board.FromFEN(fen);
+
+        if (threads)
+            return RunThreadScaling(board, depth);
+
+        return RunPerft(board, depth, divide);
+    } catch (std::exception& e) {
+        std::cout << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,186 @@
+#include "Perft.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+namespace Perft {
+
+    CHESS_MULTIVERSION uint64_t Count(Board& board, int32_t depth) {
+        if (depth <= 0)
+            return 1;
+
+        // Every legal move leads to exactly one leaf node, so they only need counting
+        if (depth == 1)
+            return board.CountLegalMoves();
+
+        MoveList moves;
+        board.GenerateLegalMoves(moves);
+
+        uint64_t nodes = 0;
+        for (PackedMove m : moves) {
+            UndoInfo undo;
+            board.MakeMove(m, undo);
+            nodes += Count(board, depth - 1);
+            board.UnmakeMove(m, undo);
+        }
+
+        return nodes;
+    }
+
+    uint64_t CountPseudoLegal(Board& board, int32_t depth) {
+        if (depth <= 0)
+            return 1;
+
+        MoveList moves;
+        board.GeneratePseudoLegalMoves(moves);
+
+        const BitBoard pinned = board.PinnedPieces();
+        const BitBoard checkers = board.Checkers();
+
+        uint64_t nodes = 0;
+        for (PackedMove m : moves) {
+            if (!board.IsLegal(m, pinned, checkers))
+                continue;
+
+            if (depth == 1) {
+                nodes++;
+                continue;
+            }
+
+            UndoInfo undo;
+            board.MakeMove(m, undo);
+            nodes += CountPseudoLegal(board, depth - 1);
+            board.UnmakeMove(m, undo);
+        }
+
+        return nodes;
+    }
+
+    HashTable::HashTable(size_t megabytes) {
+        size_t entries = 1;
+        while (entries * 2 * sizeof(Entry) <= megabytes * 1024 * 1024)
+            entries *= 2;
+
+        m_Entries = std::make_unique<Entry[]>(entries);
+        m_Mask = entries - 1;
+    }
+
+    bool HashTable::Probe(uint64_t hash, int32_t depth, uint64_t& nodes) const {
+        const Entry& entry = m_Entries[hash & m_Mask];
+        const uint64_t key = entry.Key.load(std::memory_order_relaxed);
+        const uint64_t data = entry.Data.load(std::memory_order_relaxed);
+
+        if ((key ^ data) != hash || (data & 0xFF) != (uint64_t)depth)
+            return false;
+
+        nodes = data >> 8;
+        return true;
+    }
+
+    void HashTable::Store(uint64_t hash, int32_t depth, uint64_t nodes) {
+        Entry& entry = m_Entries[hash & m_Mask];
+        const uint64_t data = (nodes << 8) | (uint64_t)depth;
+
+        entry.Key.store(hash ^ data, std::memory_order_relaxed);
+        entry.Data.store(data, std::memory_order_relaxed);
+    }
+
+    void HashTable::Clear() {
+        for (uint64_t i = 0; i <= m_Mask; i++) {
+            m_Entries[i].Key.store(0, std::memory_order_relaxed);
+            m_Entries[i].Data.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t Count(Board& board, int32_t depth, HashTable& table) {
+        if (depth <= 1)
+            return Count(board, depth);
+
+        uint64_t nodes = 0;
+        if (table.Probe(board.Hash(), depth, nodes))
+            return nodes;
+
+        MoveList moves;
+        board.GenerateLegalMoves(moves);
+
+        for (PackedMove m : moves) {
+            UndoInfo undo;
+            board.MakeMove(m, undo);
+            nodes += Count(board, depth - 1, table);
+            board.UnmakeMove(m, undo);
+        }
+
+        table.Store(board.Hash(), depth, nodes);
+        return nodes;
+    }
+
+    ParallelResult CountParallel(const Board& board, int32_t depth, size_t threads, HashTable* table) {
+        threads = std::max<size_t>(threads, 1);
+
+        ParallelResult result;
+        result.Threads.resize(threads);
+
+        if (depth <= 1) {
+            Board copy = board;
+            result.Nodes = Count(copy, depth);
+            return result;
+        }
+
+        MoveList moves;
+        board.GenerateLegalMoves(moves);
+
+        // The index of the next root move to count
+        std::atomic<size_t> next = 0;
+
+        auto work = [&](ThreadResult& threadResult) {
+            using Clock = std::chrono::steady_clock;
+            const Clock::time_point start = Clock::now();
+
+            Board copy = board;
+            for (size_t i = next++; i < moves.Size(); i = next++) {
+                UndoInfo undo;
+                copy.MakeMove(moves[i], undo);
+                threadResult.Nodes += table ? Count(copy, depth - 1, *table) : Count(copy, depth - 1);
+                copy.UnmakeMove(moves[i], undo);
+            }
+
+            threadResult.Seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        };
+
+        // This thread counts too, as one of the 'threads'
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < threads; i++)
+            workers.emplace_back(work, std::ref(result.Threads[i]));
+        work(result.Threads[0]);
+
+        for (std::thread& worker : workers)
+            worker.join();
+
+        for (const ThreadResult& threadResult : result.Threads)
+            result.Nodes += threadResult.Nodes;
+
+        return result;
+    }
+
+    std::vector<std::pair<PackedMove, uint64_t>> Divide(Board& board, int32_t depth) {
+        std::vector<std::pair<PackedMove, uint64_t>> result;
+
+        if (depth <= 0)
+            return result;
+
+        MoveList moves;
+        board.GenerateLegalMoves(moves);
+
+        for (PackedMove m : moves) {
+            UndoInfo undo;
+            board.MakeMove(m, undo);
+            result.emplace_back(m, Count(board, depth - 1));
+            board.UnmakeMove(m, undo);
+        }
+
+        return result;
+    }
+
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "Chess/Board.h"
+
+// Perft (performance test) walks the tree of legal moves to a fixed depth
+// and counts the leaf nodes. The counts are compared against known values
+// to find move generation bugs, and the speed is used as a benchmark.
+// https://www.chessprogramming.org/Perft
+
+namespace Perft {
+
+    // Returns the number of leaf nodes 'depth' plies below 'board'
+    // 'board' is returned in the same position it was given in
+    uint64_t Count(Board& board, int32_t depth);
+
+    // Same as Count(), but generates pseudo-legal moves and only plays the ones that pass Board::IsLegal()
+    // The counts must match Count(), which makes it a test of the pseudo-legal path
+    uint64_t CountPseudoLegal(Board& board, int32_t depth);
+
+    // A table of node counts by position hash and depth, shared by all the threads counting a tree
+    // There are no locks: an entry stores its key XORed with its data, so an entry torn by two threads
+    // writing at once no longer matches its key, and is treated as a miss
+    // https://www.chessprogramming.org/Shared_Hash_Table#Lockless
+    class HashTable {
+    public:
+        explicit HashTable(size_t megabytes);  // Rounded down to a power of two
+
+        // Returns true and sets 'nodes' if the count for 'hash' at 'depth' is stored
+        bool Probe(uint64_t hash, int32_t depth, uint64_t& nodes) const;
+        void Store(uint64_t hash, int32_t depth, uint64_t nodes);  // Always replaces the entry
+
+        void Clear();
+    private:
+        struct Entry {
+            std::atomic<uint64_t> Key;   // The hash XORed with Data
+            std::atomic<uint64_t> Data;  // The node count in the top 56 bits, and the depth in the bottom 8
+        };
+
+        std::unique_ptr<Entry[]> m_Entries;
+        uint64_t m_Mask = 0;  // The number of entries - 1
+    };
+
+    // Same as Count(), but looks up and stores the counts of the positions at least 2 plies above the leaves in 'table'
+    uint64_t Count(Board& board, int32_t depth, HashTable& table);
+
+    // The leaf nodes a thread counted, and how long it was busy
+    struct ThreadResult {
+        uint64_t Nodes = 0;
+        double Seconds = 0.0;
+    };
+
+    struct ParallelResult {
+        uint64_t Nodes = 0;
+        std::vector<ThreadResult> Threads;
+    };
+
+    // Same as Count(), but the root moves are shared out between 'threads' threads
+    // Each thread takes the next root move when it finishes one, and plays it on its own copy of 'board'
+    // 'table' is shared by all the threads, or not used if it's null
+    ParallelResult CountParallel(const Board& board, int32_t depth, size_t threads, HashTable* table);
+
+    // Same as Count(), but returns the number of nodes below each root move
+    std::vector<std::pair<PackedMove, uint64_t>> Divide(Board& board, int32_t depth);
+
+    struct TestPosition {
+        std::string_view Name;
+        std::string_view FEN;
+        int32_t Depth;
+        uint64_t Nodes;  // The correct number of leaf nodes at 'Depth'
+    };
+
+    // Positions with known node counts
+    // Sources:
+    // https://www.chessprogramming.org/Perft_Results
+    // http://www.talkchess.com/forum3/viewtopic.php?t=47318 (edge cases by Martin Sedlak)
+    inline constexpr TestPosition TestSuite[] = {
+        { "Start position",              "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",               5, 4865609 },
+        { "Kiwipete",                    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",   4, 4085603 },
+        { "Position 3",                  "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",                              6, 11030083 },
+        { "Position 4",                  "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",       5, 15833292 },
+        { "Position 5",                  "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",              4, 2103487 },
+        { "Position 6",                  "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4, 3894594 },
+        { "Illegal en passant #1",       "3k4/3p4/8/K1P4r/8/8/8/8 b - - 0 1",                                      6, 1134888 },
+        { "Illegal en passant #2",       "8/8/4k3/8/2p5/8/B2P2K1/8 w - - 0 1",                                     6, 1015133 },
+        { "En passant gives check",      "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1",                                    6, 1440467 },
+        { "Short castle gives check",    "5k2/8/8/8/8/8/8/4K2R w K - 0 1",                                         6, 661072 },
+        { "Long castle gives check",     "3k4/8/8/8/8/8/8/R3K3 w Q - 0 1",                                         6, 803711 },
+        { "Castling rights",             "r3k2r/1b4bq/8/8/8/8/7B/R3K2R w KQkq - 0 1",                              4, 1274206 },
+        { "Castling prevented",          "r3k2r/8/3Q4/8/8/5q2/8/R3K2R b KQkq - 0 1",                               4, 1720476 },
+        { "Promote out of check",        "2K2r2/4P3/8/8/8/8/8/3k4 w - - 0 1",                                      6, 3821001 },
+        { "Discovered check",            "8/8/1P2K3/8/2n5/1q6/8/5k2 b - - 0 1",                                    5, 1004658 },
+        { "Promote to give check",       "4k3/1P6/8/8/8/8/K7/8 w - - 0 1",                                         6, 217342 },
+        { "Under promote to give check", "8/P1k5/K7/8/8/8/8/8 w - - 0 1",                                          6, 92683 },
+        { "Self stalemate",              "K1k5/8/P7/8/8/8/8/8 w - - 0 1",                                          6, 2217 },
+        { "Stalemate and checkmate",     "8/k1P5/8/1K6/8/8/8/8 w - - 0 1",                                         7, 567584 },
+        { "Double check",                "8/8/2k5/5q2/5n2/8/5K2/8 b - - 0 1",                                      4, 23527 },
+    };
+
+}